@@ -84,13 +84,14 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void select_sector (struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
 
 static void wait_until_idle (const struct disk *);
 static bool wait_while_busy (const struct disk *);
+static bool wait_for_interrupt (struct channel *);
 static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
@@ -209,44 +210,83 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
+	disk_read_multiple (d, sec_no, buffer, 1);
+}
+
+/* Write sector SEC_NO to disk D from BUFFER, which must contain
+   DISK_SECTOR_SIZE bytes.  Returns after the disk has
+   acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	disk_write_multiple (d, sec_no, buffer, 1);
+}
+
+/* Reads CNT consecutive sectors, starting at SEC_NO, from disk D
+   into BUFFER, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes.  The whole run is transferred with a single PIO command,
+   so this is cheaper than CNT calls to disk_read().
+   CNT must be between 1 and DISK_MAX_SECTORS_PER_CMD. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no, void *buffer,
+		size_t cnt) {
 	struct channel *c;
+	uint8_t *p = buffer;
+	size_t i;
 
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
+	ASSERT (cnt > 0 && cnt <= DISK_MAX_SECTORS_PER_CMD);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
+	select_sector (d, sec_no, cnt);
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
+	for (i = 0; i < cnt; i++, p += DISK_SECTOR_SIZE) {
+		/* The device interrupts once per sector when its data is
+		   ready in the data register. */
+		if (!wait_for_interrupt (c) || !wait_while_busy (d))
+			PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name,
+					sec_no + (disk_sector_t) i);
+		input_sector (c, p);
+	}
+	d->read_cnt += cnt;
 	lock_release (&c->lock);
 }
 
-/* Write sector SEC_NO to disk D from BUFFER, which must contain
-   DISK_SECTOR_SIZE bytes.  Returns after the disk has
-   acknowledged receiving the data.
-   Internally synchronizes accesses to disks, so external
-   per-disk locking is unneeded. */
+/* Writes CNT consecutive sectors, starting at SEC_NO, to disk D
+   from BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes,
+   with a single PIO command.  Returns after the disk has
+   acknowledged receiving all of the data.
+   CNT must be between 1 and DISK_MAX_SECTORS_PER_CMD. */
 void
-disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+disk_write_multiple (struct disk *d, disk_sector_t sec_no,
+		const void *buffer, size_t cnt) {
 	struct channel *c;
+	const uint8_t *p = buffer;
+	size_t i;
 
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
+	ASSERT (cnt > 0 && cnt <= DISK_MAX_SECTORS_PER_CMD);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
+	select_sector (d, sec_no, cnt);
 	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
+	for (i = 0; i < cnt; i++, p += DISK_SECTOR_SIZE) {
+		/* The device asks for each sector in turn and interrupts
+		   once it has taken it. */
+		if (!wait_while_busy (d))
+			PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name,
+					sec_no + (disk_sector_t) i);
+		output_sector (c, p);
+		if (!wait_for_interrupt (c))
+			PANIC ("%s: disk write timed out, sector=%"PRDSNu, d->name,
+					sec_no + (disk_sector_t) i);
+	}
+	d->write_cnt += cnt;
 	lock_release (&c->lock);
 }
 
@@ -354,8 +394,7 @@ identify_ata_device (struct disk *d) {
 	   into our buffer. */
 	select_device_wait (d);
 	issue_pio_command (c, CMD_IDENTIFY_DEVICE);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d)) {
+	if (!wait_for_interrupt (c) || !wait_while_busy (d)) {
 		d->is_ata = false;
 		return;
 	}
@@ -402,17 +441,19 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and the sector count CNT to the disk's sector
+   selection registers.  (We use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
 	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (cnt <= d->capacity - sec_no);
+	ASSERT (sec_no + cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	/* A count of 0 asks for DISK_MAX_SECTORS_PER_CMD sectors. */
+	outb (reg_nsect (c), cnt == DISK_MAX_SECTORS_PER_CMD ? 0 : cnt);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
@@ -490,6 +531,27 @@ wait_while_busy (const struct disk *d) {
 	return false;
 }
 
+/* Wait up to 30 seconds, as long as wait_while_busy(), for the
+   interrupt that ends the command in progress on channel C.  Returns
+   false if it never comes, rather than hanging the caller.  An
+   interrupt that arrives after the time ran out is then ignored, so
+   that it cannot be taken for the end of the next command. */
+static bool
+wait_for_interrupt (struct channel *c) {
+	enum intr_level old_level;
+
+	if (sema_down_timeout (&c->completion_wait, 30 * TIMER_FREQ))
+		return true;
+
+	/* The interrupt may also have come in just after the time ran
+	   out, before interrupts were turned off here. */
+	old_level = intr_disable ();
+	c->expecting_interrupt = false;
+	sema_init (&c->completion_wait, 0);
+	intr_set_level (old_level);
+	return false;
+}
+
 /* Program D's channel so that D is now the selected disk. */
 static void
 select_device (const struct disk *d) {
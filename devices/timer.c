@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -24,18 +25,63 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* TSC clocksource.  timer_calibrate() counts the TSC cycles in a
+   number of PIT ticks; timer_ns() then converts cycles to
+   nanoseconds with a multiplier holding ns per cycle in 32.32 fixed
+   point.  Until then, timer_ns() has only tick resolution. */
+#define NS_PER_TICK (1000000000 / TIMER_FREQ)
+#define TSC_CALIBRATE_TICKS (TIMER_FREQ / 10)
+static uint64_t tsc_hz;                 /* TSC cycles per second. */
+static uint64_t tsc_mult;               /* ns per cycle << 32; 0 until
+                                           calibrated. */
+static uint64_t tsc_base;               /* TSC at TSC_BASE_NS. */
+static int64_t tsc_base_ns;
+static void tsc_sleep (int64_t ns);
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
 
-/* Add */
-static struct list sleep_list;
-static struct lock memory_lock;
-
-void check_wakeup_thread();
-bool wakeup_tick_less(const struct list_elem *a, const struct list_elem *b, void *aux);
-void print_sleep_list(void);
+/* Hierarchical timer wheel holding the armed timeouts.  Level L has
+   WHEEL_SIZE slots of WHEEL_SIZE^L ticks each; a timeout goes into
+   the lowest level whose span reaches its deadline, and moves down a
+   level each time the level below wraps around.  Arming, cancelling
+   and expiring a timeout are all O(1), and a tick only visits the
+   timeouts that are due.  Deadlines further out than the top level
+   reaches wait in its last slot and are placed again when it comes
+   round.  Protected by disabling interrupts. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)    /* Slots per level. */
+#define WHEEL_LEVELS 4                  /* Reaches 2^24 ticks ahead. */
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static int64_t wheel_next;              /* Next tick to expire. */
+
+static void wheel_insert (struct timeout *);
+static void wheel_cascade (int level);
+static void wheel_expire (void);
+static void timer_wakeup (void *t_);
+
+/* Tickless idle.  While the idle thread waits for an interrupt with
+   nothing to run, the PIT is put in one-shot mode to interrupt at the
+   next tick that has work due rather than at every tick.  The ticks
+   skipped are added to TICKS when it fires, or when another interrupt
+   ends the wait first.  The PIT's 16-bit count limits one wait to
+   0xffff / pit_count ticks, 5 at TIMER_FREQ 100.  On by default, so
+   that an idle machine does not wake up for every tick; the -periodic
+   kernel option turns it off. */
+bool timer_tickless = true;
+static uint16_t pit_count;              /* PIT counts per tick. */
+static int64_t oneshot_ticks;           /* Ticks the one-shot ends; 0 if
+                                           the PIT is periodic. */
+static uint16_t oneshot_counts;         /* Counts it was programmed for. */
+static uint16_t oneshot_partial;        /* Counts of the current tick
+                                           already gone when armed. */
+static int64_t mlfqs_ticks;             /* Last tick the MLFQS handled. */
+static long long skipped_cnt;           /* # of ticks skipped while idle. */
+
+static void pit_program (int mode, uint16_t count);
+static uint16_t pit_read (bool *fired);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -45,12 +91,14 @@ timer_init (void) {
 	/* 8254 input frequency divided by TIMER_FREQ, rounded to
 	   nearest. */
 	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	int level, slot;
 
-	list_init(&sleep_list);
+	for (level = 0; level < WHEEL_LEVELS; level++)
+		for (slot = 0; slot < WHEEL_SIZE; slot++)
+			list_init (&wheel[level][slot]);
 
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
+	pit_count = count;
+	pit_program (2, count);
 
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
@@ -78,6 +126,21 @@ timer_calibrate (void) {
 			loops_per_tick |= test_bit;
 
 	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+	/* Count TSC cycles across whole ticks, starting at a tick edge. */
+	int64_t start = ticks;
+	uint64_t tsc_start;
+	while (ticks == start)
+		barrier ();
+	start = ticks;
+	tsc_start = rdtsc ();
+	while (ticks - start < TSC_CALIBRATE_TICKS)
+		barrier ();
+	tsc_base = rdtsc ();
+	tsc_base_ns = ticks * NS_PER_TICK;
+	tsc_hz = (tsc_base - tsc_start) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+	tsc_mult = ((uint64_t) 1000000000 << 32) / tsc_hz;
+	printf ("Calibrating TSC...  %'"PRIu64" Hz.\n", tsc_hz);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -97,21 +160,143 @@ timer_elapsed (int64_t then) {
 	return timer_ticks () - then;
 }
 
+/* Returns the number of nanoseconds since the OS booted, read from
+   the TSC once timer_calibrate() has run.  May be called from an
+   interrupt handler. */
+int64_t
+timer_ns (void) {
+	if (tsc_mult == 0)
+		return timer_ticks () * NS_PER_TICK;
+	return tsc_base_ns
+		+ (int64_t) (((unsigned __int128) (rdtsc () - tsc_base) * tsc_mult) >> 32);
+}
+
 /* Suspends execution for approximately TICKS timer ticks. */
 void
 timer_sleep (int64_t ticks) {
-	struct sleeping_thread st;
-	
-	st.t = thread_current();
-	st.wakeup_ticks = timer_ticks() + ticks;
+	struct timeout to;
+	int64_t start = timer_ticks ();
 
+	timeout_init (&to, timer_wakeup, thread_current ());
 	enum intr_level old_level = intr_disable();
-	list_insert_ordered(&sleep_list, &st.elem, wakeup_tick_less, NULL);
-
+	timeout_arm (&to, start + ticks);
 	thread_block();
 	intr_set_level(old_level);
 }
 
+/* Timeout function of timer_sleep(): wakes up T_, the sleeper. */
+static void
+timer_wakeup (void *t_) {
+	thread_unblock (t_);
+}
+
+/* Initializes TO, a timeout that will call FUNC with AUX in the
+   timer interrupt handler once it is armed and due. */
+void
+timeout_init (struct timeout *to, timeout_func *func, void *aux) {
+	ASSERT (to != NULL);
+	ASSERT (func != NULL);
+
+	to->func = func;
+	to->aux = aux;
+	to->armed = false;
+}
+
+/* Arms TO to expire at the timer tick DEADLINE, as returned by
+   timer_ticks(), or at the next tick if DEADLINE has passed.
+   Rearming an armed timeout moves it.  May be called from an
+   interrupt handler. */
+void
+timeout_arm (struct timeout *to, int64_t deadline) {
+	enum intr_level old_level = intr_disable ();
+
+	if (to->armed)
+		list_remove (&to->elem);
+	to->deadline = deadline;
+	to->armed = true;
+	wheel_insert (to);
+	intr_set_level (old_level);
+}
+
+/* Disarms TO.  Returns true if it was armed, false if it had already
+   expired or was never armed.  May be called from an interrupt
+   handler. */
+bool
+timeout_cancel (struct timeout *to) {
+	enum intr_level old_level = intr_disable ();
+	bool armed = to->armed;
+
+	if (armed) {
+		list_remove (&to->elem);
+		to->armed = false;
+	}
+	intr_set_level (old_level);
+	return armed;
+}
+
+/* Puts TO in the wheel slot for its deadline. */
+static void
+wheel_insert (struct timeout *to) {
+	int64_t expires = to->deadline > wheel_next ? to->deadline : wheel_next;
+	int64_t delta = expires - wheel_next;
+	int level;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if (delta < (int64_t) 1 << (WHEEL_BITS * (level + 1)))
+			break;
+	if (delta >= (int64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS))
+		expires = wheel_next + ((int64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+	list_push_back (&wheel[level][(expires >> (WHEEL_BITS * level))
+			& (WHEEL_SIZE - 1)], &to->elem);
+}
+
+/* Moves the timeouts of LEVEL's slot for wheel_next down to the
+   levels below, after cascading the level above if this slot is the
+   first of LEVEL. */
+static void
+wheel_cascade (int level) {
+	int slot = (wheel_next >> (WHEEL_BITS * level)) & (WHEEL_SIZE - 1);
+	struct list *list = &wheel[level][slot];
+	struct list pending;
+
+	if (slot == 0 && level + 1 < WHEEL_LEVELS)
+		wheel_cascade (level + 1);
+
+	list_init (&pending);
+	while (!list_empty (list))
+		list_push_back (&pending, list_pop_front (list));
+	while (!list_empty (&pending))
+		wheel_insert (list_entry (list_pop_front (&pending),
+					struct timeout, elem));
+}
+
+/* Expires every timeout due at or before TICKS, then decides once
+   whether a thread they woke should preempt the running one. */
+static void
+wheel_expire (void) {
+	bool expired = false;
+
+	while (wheel_next <= ticks) {
+		struct list *list = &wheel[0][wheel_next & (WHEEL_SIZE - 1)];
+
+		if ((wheel_next & (WHEEL_SIZE - 1)) == 0)
+			wheel_cascade (1);
+		while (!list_empty (list)) {
+			struct timeout *to = list_entry (list_pop_front (list),
+					struct timeout, elem);
+
+			to->armed = false;
+			to->func (to->aux);
+			expired = true;
+		}
+		wheel_next++;
+	}
+	if (expired)
+		check_priority ();
+}
+
 /* Suspends execution for approximately MS milliseconds. */
 void
 timer_msleep (int64_t ms) {
@@ -130,27 +315,131 @@ timer_nsleep (int64_t ns) {
 	real_time_sleep (ns, 1000 * 1000 * 1000);
 }
 
+/* Returns the number of timer ticks skipped while idle so far. */
+int64_t
+timer_skipped_ticks (void) {
+	enum intr_level old_level = intr_disable ();
+	int64_t t = skipped_cnt;
+	intr_set_level (old_level);
+	barrier ();
+	return t;
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
 	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	if (skipped_cnt > 0)
+		printf ("Timer: %lld ticks skipped while idle\n", skipped_cnt);
+}
+
+/* Programs counter 0 of the PIT to count down from COUNT in MODE:
+   2 interrupts every COUNT counts, 0 once after COUNT counts. */
+static void
+pit_program (int mode, uint16_t count) {
+	outb (0x43, 0x30 | (mode << 1)); /* CW: counter 0, LSB then MSB, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* Returns the current count of counter 0 of the PIT, and sets *FIRED
+   to whether its output is high, which in mode 0 means that the count
+   has run out. */
+static uint16_t
+pit_read (bool *fired) {
+	uint8_t status, lo, hi;
+
+	outb (0x43, 0xc2);    /* Read-back: latch count and status, counter 0. */
+	status = inb (0x40);
+	lo = inb (0x40);
+	hi = inb (0x40);
+	*fired = (status & 0x80) != 0;
+	return lo | (hi << 8);
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts with nothing to run.  Unless the next tick has work due,
+   switches the PIT to one-shot mode, to interrupt at the first tick
+   that expires a timeout or cascades the wheel, as far ahead as the
+   PIT can count. */
+void
+timer_idle_enter (void) {
+	int64_t deadline, max = 0xffff / pit_count;
+	uint16_t partial;
+	bool fired;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!timer_tickless || oneshot_ticks > 0)
+		return;
+	for (deadline = ticks + 1; deadline < ticks + max; deadline++)
+		if ((deadline & (WHEEL_SIZE - 1)) == 0
+				|| !list_empty (&wheel[0][deadline & (WHEEL_SIZE - 1)]))
+			break;
+	if (deadline - ticks < 2)
+		return;
+
+	/* The periodic count runs from PIT_COUNT down to 1. */
+	partial = pit_count - pit_read (&fired);
+	oneshot_ticks = deadline - ticks;
+	oneshot_partial = partial;
+	oneshot_counts = oneshot_ticks * pit_count - partial;
+	pit_program (0, oneshot_counts);
+}
+
+/* Called by the scheduler, with interrupts off, when the idle thread
+   stops running.  If an interrupt other than the one-shot ended the
+   wait, adds the ticks that have passed and sets the one-shot to end
+   the tick in progress, after which the PIT is periodic again. */
+void
+timer_idle_exit (void) {
+	uint16_t count, elapsed;
+	bool fired;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (oneshot_ticks <= 1)
+		return;
+	count = pit_read (&fired);
+	if (fired)
+		return;         /* Its interrupt is pending. */
+	if (count > oneshot_counts)
+		count = oneshot_counts;         /* Not loaded yet. */
+
+	elapsed = oneshot_partial + (oneshot_counts - count);
+	ticks += elapsed / pit_count;
+	skipped_cnt += elapsed / pit_count;
+	oneshot_ticks = 1;
+	oneshot_partial = elapsed % pit_count;
+	oneshot_counts = pit_count - oneshot_partial;
+	pit_program (0, oneshot_counts);
 }
 
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
+	if (oneshot_ticks > 0) {
+		/* A one-shot ended: count the ticks it skipped, and go back to
+		   interrupting every tick. */
+		ticks += oneshot_ticks - 1;
+		skipped_cnt += oneshot_ticks - 1;
+		oneshot_ticks = 0;
+		pit_program (2, pit_count);
+	}
 	ticks++;
 	if(thread_mlfqs){
 		mlfqs_incr(); // 현재 쓰레드의 recent_cpu +1
-		if (ticks % 4 == 0) {
-			mlfqs_recalculate_priority();
-			if (ticks % TIMER_FREQ == 0) {
+		while (mlfqs_ticks < ticks) {	// 유휴 중 건너뛴 틱도 처리
+			mlfqs_ticks++;
+			if (mlfqs_ticks % TIMER_FREQ == 0) {
 				mlfqs_load_avg();
-				mlfqs_recalculate_recent_cpu();
+				mlfqs_recalculate_recent_cpu();	// 실행 중·준비 스레드만 감쇠
 			}
+			if (mlfqs_ticks % 4 == 0)
+				mlfqs_recalculate_priority();	// recent_cpu가 바뀐 스레드만 재계산
 		}
 	}
-	check_wakeup_thread();	// 깨워야 할 스레드 체크
+	wheel_expire ();	// 만료된 타임아웃 처리, 선점 여부는 한 번만 판단
 	thread_tick ();
 }
 
@@ -197,7 +486,10 @@ real_time_sleep (int64_t num, int32_t denom) {
 	int64_t ticks = num * TIMER_FREQ / denom;
 
 	ASSERT (intr_get_level () == INTR_ON);
-	if (ticks > 0) {
+	if (tsc_mult != 0) {
+		/* DENOM divides 10^9. */
+		tsc_sleep (num * (1000000000 / denom));
+	} else if (ticks > 0) {
 		/* We're waiting for at least one full timer tick.  Use
 		   timer_sleep() because it will yield the CPU to other 
 		   processes. */
@@ -211,40 +503,16 @@ real_time_sleep (int64_t num, int32_t denom) {
 	}
 }
 
-void check_wakeup_thread() {
-    struct list_elem *e = list_begin(&sleep_list);
-	int64_t now_ticks = timer_ticks();
-
-
-	while (e != list_end(&sleep_list)) {
-		struct sleeping_thread *st = list_entry(e, struct sleeping_thread, elem);
-
-		if (st->wakeup_ticks <= now_ticks) {
-			e = list_remove(e);
-			thread_unblock(st->t);
-			check_priority();
-		} else {
-			break;
-		}
-	}
-}
+/* Sleeps for NS nanoseconds: blocks for the whole ticks that fit,
+   letting other threads run, then spins on the TSC for the rest.
+   timer_sleep(N) never lasts more than N ticks, short of scheduling
+   delays, so the spin covers less than a tick. */
+static void
+tsc_sleep (int64_t ns) {
+	int64_t deadline = timer_ns () + ns;
 
-bool wakeup_tick_less(const struct list_elem *a, const struct list_elem *b, void *aux) {
-    const struct sleeping_thread *sleep_a = list_entry(a, struct sleeping_thread, elem);
-    const struct sleeping_thread *sleep_b = list_entry(b, struct sleeping_thread, elem);
-    return sleep_a->wakeup_ticks < sleep_b->wakeup_ticks;
+	if (ns >= NS_PER_TICK)
+		timer_sleep (ns / NS_PER_TICK);
+	while (timer_ns () < deadline)
+		barrier ();
 }
-
-void print_sleep_list(void) {
-    struct list_elem *e;
-
-    for (e = list_begin(&sleep_list); e != list_end(&sleep_list); e = list_next(e)) {
-        struct sleeping_thread *st = (st = list_entry(e, struct sleeping_thread, elem)) != NULL ? st : NULL;
-        if (st != NULL && st->t != NULL) {
-			printf("##################################### Thread: %d, Wakeup time: %" PRId64 "\n", st->t->tid, st->wakeup_ticks);
-		} else {
-			printf("Invalid thread or wakeup time.\n");
-		}
-    }
-	printf("----------------\n");
-}
\ No newline at end of file
@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -12,6 +14,7 @@ void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+int64_t timer_ns (void);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
@@ -20,4 +23,26 @@ void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+/* Tickless idle. */
+extern bool timer_tickless;
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+int64_t timer_skipped_ticks (void);
+
+/* A timeout: calls FUNC with AUX from the timer interrupt handler
+   once timer_ticks() reaches DEADLINE.  Used by timer_sleep() and
+   by kernel code that must not wait forever. */
+typedef void timeout_func (void *aux);
+struct timeout {
+	struct list_elem elem;              /* Element in a wheel slot. */
+	int64_t deadline;                   /* Tick to expire at. */
+	timeout_func *func;                 /* Called on expiry. */
+	void *aux;                          /* Argument of FUNC. */
+	bool armed;                         /* In the wheel? */
+};
+
+void timeout_init (struct timeout *, timeout_func *, void *aux);
+void timeout_arm (struct timeout *, int64_t deadline);
+bool timeout_cancel (struct timeout *);
+
 #endif /* devices/timer.h */
@@ -119,6 +119,14 @@ static __inline uint64_t rcr2(void) {
 	return val;
 }
 
+/* Read the time-stamp counter.  See [IA32-v2b] "RDTSC". */
+__attribute__((always_inline))
+static __inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	__asm __volatile("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
 __attribute__((always_inline))
 static __inline void write_msr(uint32_t ecx, uint64_t val) {
 	uint32_t edx, eax;
@@ -36,6 +36,16 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extensions.  New calls go at the end, so that the numbers
+	   above never change. */
+	SYS_RSS_LIMIT,              /* Limit resident pages. */
+	SYS_MADVISE,                /* Give advice about memory use. */
+	SYS_OOM_SCORE_ADJ,          /* Adjust the OOM killer's choice. */
+	SYS_SPAWN,                  /* Start a new process running a program. */
+	SYS_STACK_LIMIT,            /* Limit the stack of the next exec. */
+	SYS_MSYNC,                  /* Write back a memory mapping. */
+	SYS_CLOCK_NS,               /* Read the nanosecond clock. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -4,15 +4,42 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* A descriptor for spawn() to give the new process: its CHILD_FD
+ * refers to the file that the caller's PARENT_FD does.  A list of these
+ * ends with one whose PARENT_FD is -1. */
+struct spawn_fd_action {
+	int parent_fd;
+	int child_fd;
+};
+
 /* Map region identifier. */
 typedef int off_t;
 #define MAP_FAILED ((void *) NULL)
 
+/* Return value of rss_limit() on bad limits. */
+#define RSS_ERROR ((size_t) -1)
+
+/* Advice for madvise(). */
+#define MADV_NORMAL 0           /* No special treatment. */
+#define MADV_RANDOM 1           /* Expect random accesses. */
+#define MADV_SEQUENTIAL 2       /* Expect sequential accesses. */
+#define MADV_WILLNEED 3         /* Expect access soon. */
+#define MADV_DONTNEED 4         /* Contents no longer needed. */
+
+/* Range of oom_score_adj().  The OOM killer never picks a process at
+ * the minimum. */
+#define OOM_SCORE_ADJ_MIN (-1000)
+#define OOM_SCORE_ADJ_MAX 1000
+
+/* Return value of stack_limit() on a bad limit. */
+#define STACK_LIMIT_ERROR ((size_t) -1)
+
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
@@ -37,10 +64,17 @@ unsigned tell (int fd);
 void close (int fd);
 
 int dup2(int oldfd, int newfd);
+pid_t spawn (const char *cmd_line, const struct spawn_fd_action *fd_actions);
+int64_t clock_ns (void);
 
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+size_t rss_limit (size_t soft, size_t hard);
+int madvise (void *addr, size_t length, int advice);
+int oom_score_adj (int adj);
+size_t stack_limit (size_t limit);
+int msync (void *addr, size_t length);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
@@ -111,9 +111,13 @@ struct thread {
 
 	int nice;
 	int recent_cpu;
+	int64_t decay_epoch;                /* Decays applied to recent_cpu. */
+	bool mlfqs_dirty;                   /* On the MLFQS dirty list? */
+	struct list_elem mlfqs_elem;        /* Element in that list. */
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
+	int ready_pri;                      /* Ready queue ELEM is on. */
 
 // #ifdef USERPROG
 	/* Owned by userprog/process.c. */
@@ -134,6 +138,16 @@ struct thread {
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
 	struct supplemental_page_table spt;
+	size_t rss;                         /* Resident pages, under frame_lock. */
+	size_t rss_soft_limit;              /* Evicted first above this; 0 = none. */
+	size_t rss_hard_limit;              /* Most resident pages; 0 = none. */
+	size_t swap_pages;                  /* Pages in swap, under swap_lock. */
+	int oom_score_adj;                  /* OOM_SCORE_ADJ_MIN to _MAX. */
+	bool oom_killed;                    /* Chosen by the OOM killer? */
+	size_t stack_limit;                 /* Stack size for the next exec, in
+	                                       bytes; 0 = STACK_LIMIT_DEFAULT. */
+	void *user_rsp;                     /* User stack pointer on the last
+	                                       entry into the kernel. */
 #endif
 
 	/* Owned by thread.c. */
@@ -142,15 +156,8 @@ struct thread {
 	unsigned magic;                     /* Detects stack overflow. */
 };
 
-struct sleeping_thread {
-	struct thread *t;
-	int64_t wakeup_ticks;
-	struct list_elem elem;
-};
-
 void check_priority();
 void print_ready_list(void);
-static struct list ready_list;
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
@@ -166,6 +173,10 @@ void thread_print_stats (void);
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
 
+/* Performs some operation on thread t, given auxiliary data AUX. */
+typedef void thread_action_func (struct thread *t, void *aux);
+void thread_foreach (thread_action_func *, void *);
+
 void thread_block (void);
 void thread_unblock (struct thread *);
 
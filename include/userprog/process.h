@@ -3,8 +3,21 @@
 
 #include "threads/thread.h"
 
+/* A descriptor that process_spawn() gives the new process: its CHILD_FD
+ * refers to the file that the caller's PARENT_FD does.  Matches struct
+ * spawn_fd_action in lib/user/syscall.h. */
+struct spawn_fd_action {
+	int parent_fd;
+	int child_fd;
+};
+
+/* Most descriptors spawn() may give a new process. */
+#define SPAWN_ACTIONS_MAX 32
+
 tid_t process_create_initd (const char *file_name);
 tid_t process_fork (const char *name, struct intr_frame *if_);
+tid_t process_spawn (char *cmd_line, const struct spawn_fd_action *actions,
+		size_t action_cnt);
 int process_exec (void *f_name);
 int process_wait (tid_t);
 void process_exit (void);
@@ -1,6 +1,9 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
 
 typedef int pid_t;
 extern struct lock syscall_lock;
@@ -10,6 +13,9 @@ void halt (void);
 void exit (int status);
 // pid_t fork (const char *thread_name, struct intr_frame *f); //compile error 때문에 없앰.
 int exec (const char *cmd_line);
+struct spawn_fd_action;
+pid_t spawn (const char *cmd_line, const struct spawn_fd_action *fd_actions);
+int64_t clock_ns (void);
 int wait (pid_t pid);
 bool create (const char *file, unsigned initial_size);
 bool remove (const char *file);
@@ -20,5 +26,14 @@ int write (int fd, const void *buffer, unsigned size);
 void seek (int fd, unsigned position);
 unsigned tell (int fd);
 void close (int fd);
+#ifdef VM
+void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
+void munmap (void *addr);
+size_t rss_limit (size_t soft, size_t hard);
+int madvise (void *addr, size_t length, int advice);
+int oom_score_adj (int adj);
+size_t stack_limit (size_t limit);
+int msync (void *addr, size_t length);
+#endif
 
 #endif /* userprog/syscall.h */
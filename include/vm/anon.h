@@ -2,12 +2,25 @@
 #define VM_ANON_H
 #include "vm/vm.h"
 struct page;
+struct zswap_entry;
 enum vm_type;
 
 struct anon_page {
+	size_t swap_slot;           /* Swap slot holding the page, or
+	                               BITMAP_ERROR while it is resident. */
+	struct zswap_entry *zswap;  /* Compressed copy, or NULL. */
 };
 
+/* Swap devices, as given with the -swap kernel option, or NULL. */
+extern char *swap_devices;
+
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void vm_anon_print_stats (void);
+size_t anon_swap_size (void);
+size_t anon_swap_out_cluster (struct page **pages, size_t cnt);
+bool anon_in_swap (const struct page *page);
+void anon_drop_swap (struct page *page);
+void anon_share_swap (struct page *src, struct page *dst);
 
 #endif
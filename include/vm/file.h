@@ -4,9 +4,26 @@
 #include "vm/vm.h"
 
 struct page;
+struct vma;
 enum vm_type;
 
 struct file_page {
+	struct file *file;          /* Backing file, a private reopen. */
+	off_t ofs;                  /* Offset of the page in FILE. */
+	size_t read_bytes;          /* Bytes backed by FILE; the rest of the
+	                               page is zeroes and never written back. */
+	bool text;                  /* Executable text (VM_TEXT)? */
+};
+
+/* Where the contents of a lazily loaded page come from.  Executable
+ * segments and file mappings pass one of these as the AUX of
+ * vm_alloc_page_with_initializer().  The page owns FILE, a private
+ * reopen of the backing file, and the whole structure until its
+ * initializer runs or the page is destroyed. */
+struct lazy_load_info {
+	struct file *file;          /* Backing file. */
+	off_t ofs;                  /* Offset of the page in FILE. */
+	size_t read_bytes;          /* Bytes to read; the rest is zeroed. */
 };
 
 void vm_file_init (void);
@@ -14,4 +31,9 @@ bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset);
 void do_munmap (void *va);
+bool file_backed_dup (struct page *src);
+bool file_lazy_load (struct page *page, void *aux);
+bool file_backed_writeback (struct page *page);
+bool file_backed_attach (struct page *page);
+bool file_map_page (struct vma *vma, void *va);
 #endif
@@ -1,6 +1,7 @@
 #ifndef VM_VM_H
 #define VM_VM_H
 #include <stdbool.h>
+#include <hash.h>
 #include "threads/palloc.h"
 
 enum vm_type {
@@ -24,6 +25,10 @@ enum vm_type {
 	VM_MARKER_END = (1 << 31),
 };
 
+/* Marks the read-only pages of an executable, which processes running
+ * the same binary share through the text cache. */
+#define VM_TEXT VM_MARKER_0
+
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
@@ -34,6 +39,19 @@ enum vm_type {
 struct page_operations;
 struct thread;
 
+/* Access pattern advice given with madvise().  The values match MADV_* in
+ * lib/user/syscall.h.  Pages keep the last of the first three; the
+ * others are acted upon at once. */
+enum vm_advice {
+	VM_ADV_NORMAL = 0,          /* No special treatment. */
+	VM_ADV_RANDOM = 1,          /* No fault-around or swap readahead. */
+	VM_ADV_SEQUENTIAL = 2,      /* Read ahead more, evict behind early. */
+	VM_ADV_WILLNEED = 3,        /* Read the pages in now. */
+	VM_ADV_DONTNEED = 4,        /* Drop the pages' contents. */
+};
+
+#include "vm/vma.h"
+
 #define VM_TYPE(type) ((type) & 7)
 
 /* The representation of "page".
@@ -46,6 +64,14 @@ struct page {
 	struct frame *frame;   /* Back reference for frame */
 
 	/* Your implementation */
+	struct hash_elem spt_elem;  /* Element in supplemental_page_table. */
+	struct thread *owner;       /* Process whose page table maps VA. */
+	bool writable;              /* May the user process write to VA? */
+	struct page *next_sharer;   /* Next page sharing FRAME; the pages that
+	                               share a frame form a ring. */
+	enum vm_advice advice;      /* Access pattern advice for the page. */
+	struct vma *vma;            /* File mapping the page belongs to. */
+	struct list_elem vma_elem;  /* Element in the mapping's page list. */
 
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -59,10 +85,40 @@ struct page {
 	};
 };
 
-/* The representation of "frame" */
+/* Which of the same-page merging tables a frame is in. */
+enum ksm_state {
+	KSM_NONE,                   /* Neither. */
+	KSM_UNSTABLE,               /* Candidates seen during this pass. */
+	KSM_STABLE,                 /* Frames pages have been merged into. */
+};
+
+/* The representation of "frame".
+ * Every user frame that holds a loaded page is on the global frame table,
+ * which vm.c scans with a clock hand to pick eviction victims.
+ * After fork, parent and child share their anonymous frames copy-on-write,
+ * processes running the same binary share its text, and the same-page
+ * merging scanner makes anonymous pages with identical contents share
+ * one frame: PAGE is then one of REF_CNT pages, linked by next_sharer,
+ * that map the frame read-only. */
 struct frame {
 	void *kva;
 	struct page *page;
+	unsigned ref_cnt;           /* Number of pages sharing the frame. */
+	struct list_elem elem;      /* Element in the frame table. */
+	struct page **huge;         /* For a huge frame, its HUGE_PAGES pages
+	                               in address order; otherwise NULL. */
+	bool pinned;                /* Off the frame table while its page is
+	                               written back without frame_lock. */
+
+	/* Text cache. */
+	bool cached;                /* In the text cache? */
+	uint64_t text_key;          /* Inode sector and offset of the text. */
+	struct hash_elem text_elem; /* Element in the text cache. */
+
+	/* Same-page merging. */
+	enum ksm_state ksm;         /* Merging table the frame is in. */
+	uint64_t ksm_checksum;      /* Hash of the contents when last scanned. */
+	struct hash_elem ksm_elem;  /* Element in that table. */
 };
 
 /* The function table for page operations.
@@ -82,9 +138,17 @@ struct page_operations {
 	if ((page)->operations->destroy) (page)->operations->destroy (page)
 
 /* Representation of current process's memory space.
- * We don't want to force you to obey any specific design for this struct.
- * All designs up to you for this. */
+ * Pages are indexed by their page-aligned user virtual address, so that
+ * the fault path, page allocation and user pointer validation all find a
+ * page in constant time no matter how many pages the process maps.
+ * Every page lies in one of the process's areas, which cover whatever
+ * range of the address space is in use, touched or not. */
 struct supplemental_page_table {
+	struct hash pages;          /* Pages created so far, keyed by VA. */
+	struct vma_tree vmas;       /* Areas of the address space. */
+	void *stack_bottom;         /* Lowest page of the stack, or NULL. */
+	size_t stack_batch;         /* Pages the stack grows by next time. */
+	bool dying;                 /* Being torn down, every page at once? */
 };
 
 #include "threads/thread.h"
@@ -94,10 +158,49 @@ bool supplemental_page_table_copy (struct supplemental_page_table *dst,
 void supplemental_page_table_kill (struct supplemental_page_table *spt);
 struct page *spt_find_page (struct supplemental_page_table *spt,
 		void *va);
+struct page *spt_get_page (struct supplemental_page_table *spt, void *va);
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 
+/* Pages past a faulting file-backed page that a read fault also loads. */
+extern size_t vm_fault_around;
+
+/* Timer ticks between passes of the writeback daemon; 0 disables it. */
+extern int64_t vm_writeback_interval;
+
+/* Back large zero-fill anonymous regions with huge pages? */
+extern bool vm_huge_pages;
+
+/* Timer ticks between batches of the same-page merging scanner; 0
+ * disables it. */
+extern int64_t vm_ksm_interval;
+
 void vm_init (void);
+void vm_print_stats (void);
+void vm_writeback_start (void);
+
+/* Smallest hard limit on resident pages: enough for any one instruction
+ * and the kernel's accesses on its behalf. */
+#define RSS_MIN_LIMIT 16
+#define RSS_ERROR ((size_t) -1)
+size_t vm_rss_limit (size_t soft, size_t hard);
+
+/* Range of oom_score_adj.  The OOM killer never picks a process at the
+ * minimum. */
+#define OOM_SCORE_ADJ_MIN (-1000)
+#define OOM_SCORE_ADJ_MAX 1000
+int vm_oom_score_adj (int adj);
+
+/* Stack size limits, in bytes.  The largest keeps the stack well clear
+ * of the executable and of the usual addresses for file mappings. */
+#define STACK_LIMIT_DEFAULT (1024 * 1024)
+#define STACK_LIMIT_MAX (64 * 1024 * 1024)
+#define STACK_LIMIT_ERROR ((size_t) -1)
+size_t vm_stack_limit (size_t limit);
+bool vm_setup_stack (void *top, size_t limit);
+bool vm_madvise (void *addr, size_t length, int advice);
+bool vm_msync (void *addr, size_t length);
+bool vm_reserve (void *addr, size_t length);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
 
@@ -107,6 +210,9 @@ bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
 bool vm_claim_page (void *va);
+void *vm_readahead_frame (struct page *page);
+void vm_readahead_done (struct page *page, bool loaded);
+void vm_free_frame (struct page *page, bool save);
 enum vm_type page_get_type (struct page *page);
 
 #endif  /* VM_VM_H */
@@ -0,0 +1,56 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+
+struct file;
+
+/* A virtual memory area: a page-aligned range of a process's address
+ * space.  The areas of a process never overlap.
+ *
+ * A file mapping's pages are created when first touched, from FILE,
+ * OFS and FILE_BYTES, and PAGES lists the ones created so far.  The
+ * areas of the executable's segments only reserve their ranges: their
+ * pages are created up front.  The stack's area is as far as the stack
+ * may grow, and its pages are created as it grows down into it.  FILE is
+ * NULL for both.
+ *
+ * Include vm/vm.h rather than this header. */
+struct vma {
+	void *start;                /* First page. */
+	void *end;                  /* Page past the last one. */
+	struct file *file;          /* Mapped file, a private reopen, or NULL. */
+	off_t ofs;                  /* Offset in FILE of START. */
+	size_t file_bytes;          /* Bytes of FILE mapped from START; the
+	                               rest of the area reads as zeroes. */
+	bool writable;              /* May the user process write to it? */
+	enum vm_advice advice;      /* Advice for the pages created later. */
+	bool stack;                 /* The stack's area? */
+	struct list pages;          /* Pages created so far. */
+	size_t page_cnt;            /* Number of pages in PAGES. */
+
+	/* AVL tree. */
+	struct vma *left, *right;   /* Areas below and above this one. */
+	int height;                 /* Height of the subtree rooted here. */
+};
+
+/* The areas of a process, in a balanced tree ordered by address, so
+ * that finding the area at an address, or the first one that overlaps
+ * a range, takes O(log n). */
+struct vma_tree {
+	struct vma *root;
+};
+
+void vma_tree_init (struct vma_tree *tree);
+bool vma_insert (struct vma_tree *tree, struct vma *vma);
+void vma_remove (struct vma_tree *tree, struct vma *vma);
+struct vma *vma_find (struct vma_tree *tree, void *addr);
+struct vma *vma_find_overlap (struct vma_tree *tree, void *start, void *end);
+bool vma_tree_for_each (struct vma_tree *tree,
+		bool (*action) (struct vma *, void *aux), void *aux);
+void vma_tree_clear (struct vma_tree *tree,
+		void (*destructor) (struct vma *));
+
+#endif
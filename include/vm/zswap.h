@@ -0,0 +1,17 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stddef.h>
+
+struct zswap_entry;
+
+/* Most pages the compressed pool may use. */
+extern size_t zswap_pool_pages;
+
+void zswap_init (void);
+struct zswap_entry *zswap_store (const void *kva);
+void zswap_load (struct zswap_entry *entry, void *kva);
+void zswap_get (struct zswap_entry *entry);
+void zswap_put (struct zswap_entry *entry);
+void zswap_print_stats (void);
+
+#endif
@@ -145,6 +145,16 @@ dup2 (int oldfd, int newfd){
 	return syscall2 (SYS_DUP2, oldfd, newfd);
 }
 
+pid_t
+spawn (const char *cmd_line, const struct spawn_fd_action *fd_actions) {
+	return (pid_t) syscall2 (SYS_SPAWN, cmd_line, fd_actions);
+}
+
+int64_t
+clock_ns (void) {
+	return (int64_t) syscall0 (SYS_CLOCK_NS);
+}
+
 void *
 mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	return (void *) syscall5 (SYS_MMAP, addr, length, writable, fd, offset);
@@ -155,6 +165,31 @@ munmap (void *addr) {
 	syscall1 (SYS_MUNMAP, addr);
 }
 
+size_t
+rss_limit (size_t soft, size_t hard) {
+	return (size_t) syscall2 (SYS_RSS_LIMIT, soft, hard);
+}
+
+int
+madvise (void *addr, size_t length, int advice) {
+	return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+int
+oom_score_adj (int adj) {
+	return syscall1 (SYS_OOM_SCORE_ADJ, adj);
+}
+
+size_t
+stack_limit (size_t limit) {
+	return (size_t) syscall1 (SYS_STACK_LIMIT, limit);
+}
+
+int
+msync (void *addr, size_t length) {
+	return syscall2 (SYS_MSYNC, addr, length);
+}
+
 bool
 chdir (const char *dir) {
 	return syscall1 (SYS_CHDIR, dir);
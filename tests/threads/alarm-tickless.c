@@ -0,0 +1,38 @@
+/* Sleeps for a range of durations with no other thread to run, so
+   that the timer skips idle ticks, and checks that each sleep still
+   lasts the number of ticks asked for: the skipped ticks must all be
+   counted, and none counted twice.  Also checks that some ticks
+   were in fact skipped. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+void
+test_alarm_tickless (void)
+{
+  static const int durations[] = {1, 2, 3, 5, 6, 11, 63, 64, 65, 130};
+  int64_t skipped = timer_skipped_ticks ();
+  size_t i;
+
+  ASSERT (timer_tickless);
+
+  for (i = 0; i < sizeof durations / sizeof *durations; i++)
+    {
+      int64_t start = timer_ticks ();
+      int64_t elapsed;
+
+      timer_sleep (durations[i]);
+      elapsed = timer_elapsed (start);
+      if (elapsed < durations[i] || elapsed > durations[i] + 1)
+        fail ("sleep of %d ticks took %lld", durations[i],
+              (long long) elapsed);
+    }
+  msg ("Every sleep lasted as long as asked.");
+
+  if (timer_skipped_ticks () == skipped)
+    fail ("no idle tick was skipped");
+  msg ("Idle ticks were skipped.");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-tickless) begin
+(alarm-tickless) Every sleep lasted as long as asked.
+(alarm-tickless) Idle ticks were skipped.
+(alarm-tickless) end
+EOF
+pass;
@@ -0,0 +1,63 @@
+/* Tests kernel timeouts: sema_down_timeout() on a semaphore that is
+   never raised must give up after its timeout, on one raised in
+   time must succeed early, and a cancelled timeout must not fire. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func up_thread;
+static timeout_func count_expiry;
+
+void
+test_alarm_timeout (void)
+{
+  struct semaphore sema;
+  struct timeout to;
+  int64_t start;
+  int fired = 0;
+
+  sema_init (&sema, 0);
+  start = timer_ticks ();
+  if (sema_down_timeout (&sema, 10))
+    fail ("sema_down_timeout succeeded on a semaphore never raised");
+  if (timer_elapsed (start) < 10)
+    fail ("sema_down_timeout gave up after %lld of 10 ticks",
+          (long long) timer_elapsed (start));
+  msg ("Timed out waiting for a semaphore never raised.");
+
+  start = timer_ticks ();
+  thread_create ("up", PRI_DEFAULT, up_thread, &sema);
+  if (!sema_down_timeout (&sema, 1000))
+    fail ("sema_down_timeout timed out on a semaphore raised in time");
+  if (timer_elapsed (start) >= 1000)
+    fail ("sema_down_timeout waited out its timeout");
+  msg ("Got a semaphore raised before the timeout.");
+
+  timeout_init (&to, count_expiry, &fired);
+  timeout_arm (&to, timer_ticks () + 5);
+  if (!timeout_cancel (&to))
+    fail ("armed timeout could not be cancelled");
+  timer_sleep (10);
+  if (fired != 0)
+    fail ("cancelled timeout fired");
+  msg ("Cancelled timeout did not fire.");
+}
+
+static void
+up_thread (void *sema_)
+{
+  timer_sleep (5);
+  sema_up (sema_);
+}
+
+static void
+count_expiry (void *fired_)
+{
+  int *fired = fired_;
+
+  (*fired)++;
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-timeout) begin
+(alarm-timeout) Timed out waiting for a semaphore never raised.
+(alarm-timeout) Got a semaphore raised before the timeout.
+(alarm-timeout) Cancelled timeout did not fire.
+(alarm-timeout) end
+EOF
+pass;
@@ -0,0 +1,74 @@
+/* Creates two threads at each priority from PRI_MIN to PRI_MAX - 1,
+   in scrambled order, while running at PRI_MAX, then drops to
+   PRI_MIN.  The threads must run from the highest priority to the
+   lowest, and the two threads of each priority in the order they
+   were created, which exercises every ready queue. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define PRI_CNT (PRI_MAX - PRI_MIN)
+#define THREAD_CNT (2 * PRI_CNT)
+
+struct queue_thread_data
+  {
+    int id;                     /* Creation order. */
+    int priority;               /* Priority. */
+  };
+
+static struct queue_thread_data data[THREAD_CNT];
+static int order[THREAD_CNT];
+static int order_cnt;
+
+static thread_func queue_thread_func;
+
+void
+test_priority_queue (void)
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  thread_set_priority (PRI_MAX);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct queue_thread_data *d = data + i;
+      char name[16];
+
+      /* 37 is prime to PRI_CNT, so each half visits every priority
+         once. */
+      d->id = i;
+      d->priority = PRI_MIN + (i * 37) % PRI_CNT;
+      snprintf (name, sizeof name, "priority %d", d->priority);
+      thread_create (name, d->priority, queue_thread_func, d);
+    }
+  thread_set_priority (PRI_MIN);
+
+  /* The thread at our new priority was queued before us. */
+  if (order_cnt != THREAD_CNT)
+    fail ("%d of %d threads ran", order_cnt, THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct queue_thread_data *d = data + order[i];
+      struct queue_thread_data *prev = i > 0 ? data + order[i - 1] : NULL;
+
+      if (prev != NULL
+          && (prev->priority < d->priority
+              || (prev->priority == d->priority && prev->id > d->id)))
+        fail ("thread %d (priority %d) ran after thread %d (priority %d)",
+              d->id, d->priority, prev->id, prev->priority);
+    }
+  msg ("%d threads ran in priority order.", THREAD_CNT);
+}
+
+static void
+queue_thread_func (void *data_)
+{
+  struct queue_thread_data *d = data_;
+
+  order[order_cnt++] = d->id;
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-queue) begin
+(priority-queue) 126 threads ran in priority order.
+(priority-queue) end
+EOF
+pass;
@@ -0,0 +1,31 @@
+/* Child process run by spawn-read test.
+
+   The descriptor passed as the first command-line argument is
+   open in the parent, which left it out of the spawn()
+   descriptor actions, so reading from it must fail here. */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+int
+main (int argc UNUSED, char *argv[]) 
+{
+  char buffer[16];
+
+  test_name = "child-closed";
+
+  msg ("begin");
+
+  if (!isdigit (*argv[1]))
+    fail ("bad command-line arguments");
+
+  int handle = atoi (argv[1]);
+  CHECK (read (handle, buffer, sizeof buffer) == -1,
+         "read from a descriptor not passed by spawn() fails");
+
+  msg ("end");
+
+  return 0;
+}
@@ -0,0 +1,39 @@
+/* Reads the nanosecond clock many times.  It must never go
+   backward, and must advance in steps much finer than a timer
+   tick, which is 10 ms: some pair of consecutive reads has to
+   differ by less than 1/100 of a tick.  The total time the reads
+   take is not checked, because it depends on how fast the
+   emulator runs. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define READS 1000
+#define TICK_NS 10000000
+
+void
+test_main (void)
+{
+  int64_t prev = clock_ns (), now;
+  int64_t min_step = 0;
+  int i;
+
+  CHECK (prev > 0, "clock_ns");
+  for (i = 0; i < READS; i++)
+    {
+      now = clock_ns ();
+      if (now < prev)
+        fail ("clock went backward");
+      if (now > prev && (min_step == 0 || now - prev < min_step))
+        min_step = now - prev;
+      prev = now;
+    }
+  msg ("clock never went backward");
+
+  if (min_step == 0)
+    fail ("clock did not advance over %d reads", READS);
+  if (min_step >= TICK_NS / 100)
+    fail ("smallest step was %lld ns", (long long) min_step);
+  msg ("clock advanced in steps finer than a tick");
+}
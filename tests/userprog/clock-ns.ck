@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(clock-ns) begin
+(clock-ns) clock_ns
+(clock-ns) clock never went backward
+(clock-ns) clock advanced in steps finer than a tick
+(clock-ns) end
+clock-ns: exit(0)
+EOF
+pass;
@@ -0,0 +1,63 @@
+/* Starts child-read with spawn(), giving it one of our descriptors
+   under another number, then checks that both processes read their
+   own copy of the file from where we left off.  Then starts
+   child-closed the same way and checks that a descriptor we leave
+   out of the actions is not open in it. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/boundary.h"
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_FD 7
+
+void
+test_main (void) 
+{
+  struct spawn_fd_action actions[2];
+  pid_t pid;
+  int handle, other;
+  int byte_cnt;
+  char *buffer;
+  char cmd_line[128];
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  buffer = get_boundary_area () - sizeof sample / 2;
+  CHECK ((byte_cnt = read (handle, buffer, 20)) == 20,
+         "read \"sample.txt\" first 20 bytes");
+
+  actions[0].parent_fd = handle;
+  actions[0].child_fd = CHILD_FD;
+  actions[1].parent_fd = -1;
+  snprintf (cmd_line, sizeof cmd_line, "%s %d", "child-read", CHILD_FD);
+  pid = spawn (cmd_line, actions);
+  if (pid == PID_ERROR)
+    fail ("spawn(\"%s\") failed", cmd_line);
+  if (wait (pid) != 0)
+    fail ("child-read failed");
+
+  byte_cnt = read (handle, buffer + 20, sizeof sample - 21);
+  if (byte_cnt != sizeof sample - 21)
+    fail ("read() returned %d instead of %zu", byte_cnt, sizeof sample - 21);
+  else if (strcmp (sample, buffer))
+    {
+      msg ("expected text:\n%s", sample);
+      msg ("text actually read:\n%s", buffer);
+      fail ("expected text differs from actual");
+    }
+  else
+    msg ("Parent success");
+
+  CHECK ((other = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+  snprintf (cmd_line, sizeof cmd_line, "%s %d", "child-closed", other);
+  pid = spawn (cmd_line, actions);
+  if (pid == PID_ERROR)
+    fail ("spawn(\"%s\") failed", cmd_line);
+  if (wait (pid) != 0)
+    fail ("child-closed failed");
+  close (other);
+  close (handle);
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(spawn-read) begin
+(spawn-read) open "sample.txt"
+(spawn-read) read "sample.txt" first 20 bytes
+(child-read) begin
+(child-read) open "sample.txt"
+(child-read) read "sample.txt" first 20 bytes
+(child-read) read "sample.txt" remainders
+(child-read) Child success
+(child-read) end
+child-read: exit(0)
+(spawn-read) Parent success
+(spawn-read) open "sample.txt" again
+(child-closed) begin
+(child-closed) read from a descriptor not passed by spawn() fails
+(child-closed) end
+child-closed: exit(0)
+(spawn-read) end
+spawn-read: exit(0)
+EOF
+pass;
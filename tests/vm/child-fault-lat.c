@@ -0,0 +1,32 @@
+/* Child process of page-fault-lat.
+   Touches PROBE_PAGES pages spread evenly across its zero-filled
+   region, timing each first-touch page fault with the time-stamp
+   counter, and returns the average number of cycles per fault. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/vm/fault-lat.h"
+
+int
+main (void)
+{
+  size_t stride = region_pages / PROBE_PAGES;
+  uint64_t total = 0;
+  size_t i;
+
+  test_name = "child-fault-lat";
+
+  for (i = 0; i < PROBE_PAGES; i++)
+    {
+      volatile char *p = region + i * stride * PAGE_SIZE;
+      uint64_t start = rdtsc ();
+      *p = 1;
+      total += rdtsc () - start;
+    }
+
+  for (i = 0; i < PROBE_PAGES; i++)
+    if (region[i * stride * PAGE_SIZE] != 1)
+      fail ("page %zu lost its contents", i * stride);
+
+  return total / PROBE_PAGES;
+}
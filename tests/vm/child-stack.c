@@ -0,0 +1,33 @@
+/* Child process of stack-limit.
+   Recurses until it has used the number of kilobytes of stack
+   given as its argument, touching every page on the way down,
+   and then returns 0x42. */
+
+#include <stdlib.h>
+#include "tests/lib.h"
+
+#define FRAME_SIZE 4096
+
+/* Uses DEPTH more frames of at least FRAME_SIZE bytes. */
+static int
+recurse (int depth)
+{
+  volatile char frame[FRAME_SIZE];
+
+  frame[0] = frame[FRAME_SIZE - 1] = depth;
+  if (depth > 0)
+    return recurse (depth - 1) + (frame[0] != (char) depth);
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  test_name = "child-stack";
+
+  if (argc != 2)
+    fail ("usage: child-stack KB");
+  if (recurse (atoi (argv[1]) * 1024 / FRAME_SIZE) != 0)
+    fail ("stack frames corrupted");
+  return 0x42;
+}
@@ -1,4 +1,8 @@
-/* Checks if fork is implemented properly with copy-on-write */
+/* Checks if fork is implemented properly with copy-on-write, and
+   measures what it costs: the fork of a process whose 2 MB data
+   segment is resident, and the child's first write to a shared
+   page.  With copy-on-write, neither depends on the size of the
+   address space. */
 
 #include <string.h>
 #include <syscall.h>
@@ -7,8 +11,10 @@
 #include "tests/lib.h"
 #include "tests/main.h"
 #include "tests/vm/large.inc"
+#include "tests/vm/tsc.h"
 
 #define CHUNK_SIZE (128 * 1024)
+#define PAGE_SIZE 4096
 
 void
 test_main (void)
@@ -17,10 +23,18 @@ test_main (void)
 	void *pa_parent;
 	void *pa_child;
 	char *buf = "Lorem ipsum";
+	uint64_t start, fork_cycles, write_cycles;
+	volatile char sum = 0;
+	size_t i;
 
 	CHECK (memcmp (buf, large, strlen (buf)) == 0, "check data consistency");
 	pa_parent = get_phys_addr((void*)large);
 
+	/* Fault in all of LARGE, so that fork has every page to share. */
+	for (i = 0; i < sizeof large; i += PAGE_SIZE)
+		sum += large[i];
+
+	start = rdtsc ();
 	child = fork ("child");
 	if (child == 0) {
 		CHECK (memcmp (buf, large, strlen (buf)) == 0, "check data consistency");
@@ -28,16 +42,20 @@ test_main (void)
 		pa_child = get_phys_addr((void*)large);
 		CHECK (pa_parent == pa_child, "two phys addrs should be the same.");
 
+		start = rdtsc ();
 		large[0] = '@';
+		write_cycles = rdtsc () - start;
 		CHECK (memcmp (buf, large, strlen (buf)) != 0, "check data change");
 
 		pa_child = get_phys_addr((void*)large);
 		CHECK (pa_parent != pa_child, "two phys addrs should not be the same.");
+		msg ("first write: %d cycles", (int) write_cycles);
 		return;
 	}
+	fork_cycles = rdtsc () - start;
 	wait (child);
+	msg ("fork: %d cycles", (int) fork_cycles);
 	CHECK (pa_parent == get_phys_addr((void*)large), "two phys addrs should be the same.");
 	CHECK (memcmp (buf, large, strlen (buf)) == 0, "check data consistency");
 	return;
 }
-
@@ -2,7 +2,10 @@
 use strict;
 use warnings;
 use tests::tests;
-check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/ cycles$/, @output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
 (cow-simple) begin
 (cow-simple) check data consistency
 (cow-simple) check data consistency
@@ -0,0 +1,38 @@
+/* Runs with a fault-around window of one page, and checks that a
+   read fault on a file mapping also loads the page after it, but
+   no more. */
+
+#include <string.h>
+#include <syscall.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/small.inc"
+
+#define PAGE_SIZE 4096
+
+void
+test_main (void)
+{
+	char *actual = (char *) 0x10000000;
+	int handle;
+	void *map;
+
+	CHECK ((handle = open ("small.txt")) > 1, "open \"small.txt\"");
+	CHECK ((map = mmap (actual, sizeof small, 0, handle, 0)) != MAP_FAILED,
+			"mmap \"small.txt\"");
+
+	msg ("read page [0]");
+	if (memcmp (actual, small, 10))
+		fail ("read of mmap'd file reported bad data");
+	CHECK (get_phys_addr (&actual[PAGE_SIZE]) != 0,
+			"check if page [1] is loaded");
+	CHECK (get_phys_addr (&actual[2 * PAGE_SIZE]) == 0,
+			"check if page [2] is not loaded");
+	CHECK (!memcmp (&actual[PAGE_SIZE], &small[PAGE_SIZE], PAGE_SIZE),
+			"check memory content of page [1]");
+
+	munmap (map);
+	close (handle);
+}
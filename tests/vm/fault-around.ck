@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fault-around) begin
+(fault-around) open "small.txt"
+(fault-around) mmap "small.txt"
+(fault-around) read page [0]
+(fault-around) check if page [1] is loaded
+(fault-around) check if page [2] is not loaded
+(fault-around) check memory content of page [1]
+(fault-around) end
+EOF
+pass;
@@ -0,0 +1,8 @@
+/* 64 MB region for child-fault-lat-l. */
+
+#include "tests/vm/fault-lat.h"
+
+#define REGION_PAGES 16384
+
+char region[REGION_PAGES * PAGE_SIZE];
+const size_t region_pages = REGION_PAGES;
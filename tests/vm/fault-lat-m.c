@@ -0,0 +1,8 @@
+/* 16 MB region for child-fault-lat-m. */
+
+#include "tests/vm/fault-lat.h"
+
+#define REGION_PAGES 4096
+
+char region[REGION_PAGES * PAGE_SIZE];
+const size_t region_pages = REGION_PAGES;
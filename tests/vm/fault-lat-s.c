@@ -0,0 +1,8 @@
+/* 1 MB region for child-fault-lat-s. */
+
+#include "tests/vm/fault-lat.h"
+
+#define REGION_PAGES 256
+
+char region[REGION_PAGES * PAGE_SIZE];
+const size_t region_pages = REGION_PAGES;
@@ -0,0 +1,19 @@
+#ifndef TESTS_VM_FAULT_LAT_H
+#define TESTS_VM_FAULT_LAT_H
+
+#include <stddef.h>
+#include "tests/vm/tsc.h"
+
+#define PAGE_SIZE 4096
+
+/* Number of first-touch faults each child times. */
+#define PROBE_PAGES 64
+
+/* Zero-filled region mapped by a child-fault-lat-* process, and its
+   size in pages.  Defined by the fault-lat-*.c file linked into each
+   child, so that the children differ only in how many pages they
+   map. */
+extern char region[];
+extern const size_t region_pages;
+
+#endif /* tests/vm/fault-lat.h */
@@ -0,0 +1,56 @@
+/* Touches a large zero-fill array with huge pages enabled and
+   checks that a huge-page aligned block of it is backed by
+   physically contiguous memory.  Then forks a child that reads
+   and writes the array, which splits the huge page for
+   copy-on-write, and checks that both processes see their own
+   data. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HUGE_SIZE (2 * 1024 * 1024)
+#define BUF_SIZE (2 * HUGE_SIZE)
+
+static char buf[BUF_SIZE];
+
+void
+test_main (void)
+{
+  char *block = (char *) (((uintptr_t) buf + HUGE_SIZE - 1)
+                          & ~(uintptr_t) (HUGE_SIZE - 1));
+  uintptr_t pa;
+  size_t i;
+  pid_t child;
+
+  block[0] = 1;
+  pa = (uintptr_t) get_phys_addr (block);
+  for (i = 0; i < HUGE_SIZE; i += PAGE_SIZE)
+    {
+      block[i] = i / PAGE_SIZE;
+      if ((uintptr_t) get_phys_addr (block + i) != pa + i)
+        fail ("page %zu of the block is not contiguous", i / PAGE_SIZE);
+    }
+  msg ("block is physically contiguous");
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      for (i = 0; i < HUGE_SIZE; i += PAGE_SIZE)
+        {
+          if (block[i] != (char) (i / PAGE_SIZE))
+            fail ("child sees wrong data in page %zu", i / PAGE_SIZE);
+          block[i] = ~block[i];
+        }
+      exit (0);
+    }
+  CHECK (wait (child) == 0, "wait for child");
+
+  for (i = 0; i < HUGE_SIZE; i += PAGE_SIZE)
+    if (block[i] != (char) (i / PAGE_SIZE))
+      fail ("parent sees wrong data in page %zu", i / PAGE_SIZE);
+  msg ("data intact after fork");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(huge-page) begin
+(huge-page) block is physically contiguous
+(huge-page) wait for child
+(huge-page) data intact after fork
+(huge-page) end
+EOF
+pass;
@@ -0,0 +1,75 @@
+/* Fills four pages with the same contents and four with contents
+   of their own, then waits, blocking on file reads, until the
+   same-page merging scanner has merged the four identical pages
+   into one frame.  The other pages must keep frames of their own,
+   and a write to one of the merged pages must change only that
+   page. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define SAME_CNT 4
+#define OWN_CNT 4
+#define MAX_ROUNDS 2000
+
+static char pages[SAME_CNT + OWN_CNT][PAGE_SIZE]
+  __attribute__ ((aligned (PAGE_SIZE)));
+
+/* Returns true if the SAME_CNT identical pages share a frame. */
+static bool
+merged (void)
+{
+  int i;
+
+  for (i = 1; i < SAME_CNT; i++)
+    if (get_phys_addr (pages[i]) != get_phys_addr (pages[0]))
+      return false;
+  return true;
+}
+
+/* Blocks on a file read, which gives the scanner time to run. */
+static void
+block_briefly (void)
+{
+  char buf[512];
+  int fd;
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  read (fd, buf, sizeof buf);
+  close (fd);
+}
+
+void
+test_main (void)
+{
+  int i, j, round;
+
+  for (i = 0; i < SAME_CNT; i++)
+    memset (pages[i], 0x5a, PAGE_SIZE);
+  for (i = SAME_CNT; i < SAME_CNT + OWN_CNT; i++)
+    memset (pages[i], i, PAGE_SIZE);
+
+  quiet = true;
+  for (round = 0; round < MAX_ROUNDS && !merged (); round++)
+    block_briefly ();
+  quiet = false;
+  if (!merged ())
+    fail ("identical pages not merged");
+  msg ("identical pages merged");
+
+  for (i = SAME_CNT; i < SAME_CNT + OWN_CNT; i++)
+    for (j = 0; j < SAME_CNT + OWN_CNT; j++)
+      if (j != i && get_phys_addr (pages[i]) == get_phys_addr (pages[j]))
+        fail ("page %d shares a frame with page %d", i, j);
+  msg ("other pages not merged");
+
+  pages[1][0] = 0x00;
+  for (i = 0; i < SAME_CNT; i++)
+    for (j = 0; j < PAGE_SIZE; j++)
+      if (pages[i][j] != (i == 1 && j == 0 ? 0x00 : 0x5a))
+        fail ("page %d byte %d is %02hhx", i, j, pages[i][j]);
+  msg ("write to a merged page is private");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(ksm-merge) begin
+(ksm-merge) identical pages merged
+(ksm-merge) other pages not merged
+(ksm-merge) write to a merged page is private
+(ksm-merge) end
+EOF
+pass;
@@ -0,0 +1,44 @@
+/* Exercises madvise(): WILLNEED reads a mapped file in without
+   touching it, SEQUENTIAL and RANDOM leave the data readable,
+   DONTNEED turns written anonymous memory back into zeros, and
+   unknown advice is rejected. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ACTUAL ((void *) 0x10000000)
+
+static char buf[4 * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+  int handle;
+  size_t i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (ACTUAL, 4096, 0, handle, 0) != MAP_FAILED, "mmap \"sample.txt\"");
+  CHECK (madvise (ACTUAL, PAGE_SIZE, MADV_WILLNEED) == 0, "madvise WILLNEED");
+  CHECK (get_phys_addr (ACTUAL) != NULL, "mapping is resident before access");
+  CHECK (madvise (ACTUAL, PAGE_SIZE, MADV_SEQUENTIAL) == 0,
+         "madvise SEQUENTIAL");
+  CHECK (!memcmp (ACTUAL, sample, strlen (sample)), "read mapping");
+  CHECK (madvise (ACTUAL, PAGE_SIZE, MADV_RANDOM) == 0, "madvise RANDOM");
+  munmap (ACTUAL);
+
+  for (i = 0; i < sizeof buf; i++)
+    buf[i] = 'x';
+  CHECK (madvise (buf, sizeof buf, MADV_DONTNEED) == 0, "madvise DONTNEED");
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != 0)
+      fail ("byte %zu is not zero after DONTNEED", i);
+  msg ("anonymous memory reads back as zeros");
+
+  CHECK (madvise (buf, sizeof buf, 42) == -1, "reject unknown advice");
+  CHECK (madvise (buf + 1, PAGE_SIZE, MADV_NORMAL) == -1,
+         "reject misaligned address");
+}
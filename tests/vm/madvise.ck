@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise) begin
+(madvise) open "sample.txt"
+(madvise) mmap "sample.txt"
+(madvise) madvise WILLNEED
+(madvise) mapping is resident before access
+(madvise) madvise SEQUENTIAL
+(madvise) read mapping
+(madvise) madvise RANDOM
+(madvise) madvise DONTNEED
+(madvise) anonymous memory reads back as zeros
+(madvise) reject unknown advice
+(madvise) reject misaligned address
+(madvise) end
+EOF
+pass;
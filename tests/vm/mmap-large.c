@@ -0,0 +1,42 @@
+/* Maps a small file over a huge region, touches a few scattered pages
+   of it, then unmaps it, many times over.  Only the touched pages may
+   cost the kernel any memory, so this must neither run out of memory
+   nor take long.  Also checks that a mapping inside the huge one is
+   refused. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define LARGE (256 * 1024 * 1024)
+#define ROUNDS 64
+
+void
+test_main (void)
+{
+  char *start = (char *) 0x10000000;
+  int handle;
+  int i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  for (i = 0; i < ROUNDS; i++)
+    {
+      char *middle = start + (i + 1) * (LARGE / (ROUNDS + 1));
+
+      if (mmap (start, LARGE, 0, handle, 0) == MAP_FAILED)
+        fail ("mmap of %d bytes failed in round %d", LARGE, i);
+      if (memcmp (start, sample, strlen (sample)))
+        fail ("read of mmap'd file reported bad data in round %d", i);
+      if (start[LARGE - 1] != 0 || middle[0] != 0)
+        fail ("bytes past the end of the file are not zero in round %d", i);
+      if (i == 0)
+        CHECK (mmap (middle - PAGE_SIZE, PAGE_SIZE, 0, handle, 0)
+               == MAP_FAILED, "try to mmap inside the large mapping");
+      munmap (start);
+    }
+  msg ("mapped and unmapped %d times", ROUNDS);
+  close (handle);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-large) begin
+(mmap-large) open "sample.txt"
+(mmap-large) try to mmap inside the large mapping
+(mmap-large) mapped and unmapped 64 times
+(mmap-large) end
+EOF
+pass;
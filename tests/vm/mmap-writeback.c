@@ -0,0 +1,42 @@
+/* Writes to a file through a mapping and, without unmapping it,
+   reads the file back with the read system call until the
+   writeback daemon has written the modified page to the file. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+#define MAX_POLLS 100000
+
+void
+test_main (void)
+{
+  int handle;
+  void *map;
+  char buf[1024];
+  int i;
+
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, 4096, 1, handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  memcpy (ACTUAL, sample, strlen (sample));
+
+  /* Poll the file while the mapping stays in place. */
+  for (i = 0; i < MAX_POLLS; i++)
+    {
+      seek (handle, 0);
+      read (handle, buf, strlen (sample));
+      if (!memcmp (buf, sample, strlen (sample)))
+        break;
+    }
+  if (i == MAX_POLLS)
+    fail ("mapped data never reached the file");
+  msg ("data written back while mapped");
+
+  munmap (map);
+  close (handle);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-writeback) begin
+(mmap-writeback) create "sample.txt"
+(mmap-writeback) open "sample.txt"
+(mmap-writeback) mmap "sample.txt"
+(mmap-writeback) data written back while mapped
+(mmap-writeback) end
+EOF
+pass;
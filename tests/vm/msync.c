@@ -0,0 +1,40 @@
+/* Writes to a file through a mapping, calls msync() on it, and
+   reads the file back with the read system call, which must
+   already see the data while the mapping stays in place.  Also
+   checks that msync() rejects a range that is not mapped. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+void
+test_main (void)
+{
+  int handle;
+  void *map;
+  char buf[1024];
+
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, 4096, 1, handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  memcpy (ACTUAL, sample, strlen (sample));
+  CHECK (msync (ACTUAL, 4096) == 0, "msync \"sample.txt\"");
+
+  seek (handle, 0);
+  CHECK (read (handle, buf, strlen (sample)) == (int) strlen (sample),
+         "read \"sample.txt\"");
+  if (memcmp (buf, sample, strlen (sample)))
+    fail ("msync did not write the mapped data to the file");
+  msg ("data written back while mapped");
+
+  CHECK (msync (ACTUAL, 4096) == 0, "msync clean mapping");
+  CHECK (msync (ACTUAL, 2 * 4096) == -1, "msync past end of mapping");
+
+  munmap (map);
+  close (handle);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(msync) begin
+(msync) create "sample.txt"
+(msync) open "sample.txt"
+(msync) mmap "sample.txt"
+(msync) msync "sample.txt"
+(msync) read "sample.txt"
+(msync) data written back while mapped
+(msync) msync clean mapping
+(msync) msync past end of mapping
+(msync) end
+EOF
+pass;
@@ -0,0 +1,62 @@
+/* Forks a child that touches far more memory than RAM and swap
+   together can hold, while the parent, which holds a little memory of
+   its own, asks the OOM killer to leave it alone.  The child must be
+   killed with exit status -1, and the parent must carry on with its
+   data intact.  For this test, Pintos memory size is 10MB and the
+   swap disk holds 4MB. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define HOG_SIZE (32 * ONE_MB)
+#define KEEP_SIZE (64 * PAGE_SIZE)
+
+static char hog[HOG_SIZE];
+static char keep[KEEP_SIZE];
+
+/* Fills the page at PAGE with pseudo-random bytes seeded by SEED, which
+   the compressed swap pool cannot shrink. */
+static void
+scribble (char *page, uint32_t seed)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_SIZE; i++)
+    {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      page[i] = seed >> 24;
+    }
+}
+
+void
+test_main (void)
+{
+  pid_t child;
+  size_t i;
+
+  CHECK (oom_score_adj (OOM_SCORE_ADJ_MIN) == 0, "protect the parent");
+  for (i = 0; i < KEEP_SIZE; i++)
+    keep[i] = i % 251;
+
+  child = fork ("hog");
+  if (child == 0)
+    {
+      oom_score_adj (0);
+      for (i = 0; i < HOG_SIZE; i += PAGE_SIZE)
+        scribble (hog + i, i + 1);
+      exit (0);
+    }
+  CHECK (wait (child) == -1, "hog was killed");
+
+  for (i = 0; i < KEEP_SIZE; i++)
+    if (keep[i] != (char) (i % 251))
+      fail ("byte %zu of the parent's memory is wrong", i);
+  msg ("parent memory intact");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(oom-kill) begin
+(oom-kill) protect the parent
+(oom-kill) hog was killed
+(oom-kill) parent memory intact
+(oom-kill) end
+EOF
+pass;
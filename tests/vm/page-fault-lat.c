@@ -0,0 +1,39 @@
+/* Measures the cost of a first-touch page fault in processes that
+   map 256, 4,096 and 16,384 pages.  Supplemental page table lookups
+   are constant-time, so the cost should not grow with the number of
+   mapped pages. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 3
+
+static const char *children[CHILD_CNT] = {
+  "child-fault-lat-s", "child-fault-lat-m", "child-fault-lat-l",
+};
+
+void
+test_main (void)
+{
+  int cycles[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pid_t pid = fork (children[i]);
+      if (pid == 0)
+        {
+          if (exec (children[i]) == -1)
+            fail ("failed to exec %s", children[i]);
+        }
+      cycles[i] = wait (pid);
+      CHECK (cycles[i] > 0, "wait for %s", children[i]);
+      msg ("%s: %d cycles/fault", children[i], cycles[i]);
+    }
+
+  /* Allow generous slack for emulator noise: a lookup that scaled
+     with the mapping count would be 64 times slower here. */
+  CHECK (cycles[CHILD_CNT - 1] < 4 * cycles[0],
+         "fault cost stays flat as the mapping count grows");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = grep (!/ cycles\/fault$/, @output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(page-fault-lat) begin
+(page-fault-lat) wait for child-fault-lat-s
+(page-fault-lat) wait for child-fault-lat-m
+(page-fault-lat) wait for child-fault-lat-l
+(page-fault-lat) fault cost stays flat as the mapping count grows
+(page-fault-lat) end
+EOF
+pass;
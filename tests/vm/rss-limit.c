@@ -0,0 +1,38 @@
+/* Sets a hard limit on the process's resident pages, touches
+   many more pages than that, and checks that the resident set
+   stays within the limit while every page keeps its data. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 512
+#define HARD_LIMIT 64
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  size_t i, rss;
+
+  CHECK (rss_limit (0, 4) == RSS_ERROR, "reject a tiny hard limit");
+  CHECK (rss_limit (HARD_LIMIT + 1, HARD_LIMIT) == RSS_ERROR,
+         "reject a soft limit above the hard limit");
+  CHECK (rss_limit (HARD_LIMIT / 2, HARD_LIMIT) != RSS_ERROR,
+         "set limits");
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    buf[i * PAGE_SIZE] = i;
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) i)
+      fail ("data in page %zu is inconsistent", i);
+  msg ("touched %d pages", PAGE_COUNT);
+
+  rss = rss_limit (0, 0);
+  if (rss > HARD_LIMIT)
+    fail ("%zu pages resident, over the limit of %d", rss, HARD_LIMIT);
+  msg ("resident set within the limit");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(rss-limit) begin
+(rss-limit) reject a tiny hard limit
+(rss-limit) reject a soft limit above the hard limit
+(rss-limit) set limits
+(rss-limit) touched 512 pages
+(rss-limit) resident set within the limit
+(rss-limit) end
+EOF
+pass;
@@ -0,0 +1,43 @@
+/* Runs child processes that use more or less stack than the
+   stack limit allows.  The default limit is 1 MB; stack_limit()
+   changes it for the programs that the process executes next,
+   which are killed if their stack grows past it. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Forks a child that executes child-stack with argument KB and
+   returns its exit status. */
+static int
+run_child (const char *kb)
+{
+  char cmd_line[32];
+  pid_t pid;
+
+  snprintf (cmd_line, sizeof cmd_line, "child-stack %s", kb);
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      exec (cmd_line);
+      fail ("exec \"%s\"", cmd_line);
+    }
+  return wait (pid);
+}
+
+void
+test_main (void)
+{
+  CHECK (stack_limit (0) == 1024 * 1024, "default stack limit is 1 MB");
+  CHECK (run_child ("768") == 0x42, "768 kB of stack within the default");
+  CHECK (run_child ("2048") == -1, "2048 kB of stack past the default");
+
+  CHECK (stack_limit (256 * 1024) == 1024 * 1024, "limit the stack to 256 kB");
+  CHECK (run_child ("128") == 0x42, "128 kB of stack within the limit");
+  CHECK (run_child ("512") == -1, "512 kB of stack past the limit");
+
+  CHECK (stack_limit ((size_t) 1 << 40) == STACK_LIMIT_ERROR,
+         "reject a huge limit");
+  CHECK (stack_limit (0) == 256 * 1024, "limit unchanged");
+}
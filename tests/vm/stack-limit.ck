@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(stack-limit) begin
+(stack-limit) default stack limit is 1 MB
+(stack-limit) 768 kB of stack within the default
+(stack-limit) 2048 kB of stack past the default
+(stack-limit) limit the stack to 256 kB
+(stack-limit) 128 kB of stack within the limit
+(stack-limit) 512 kB of stack past the limit
+(stack-limit) reject a huge limit
+(stack-limit) limit unchanged
+(stack-limit) end
+EOF
+pass;
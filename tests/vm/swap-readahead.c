@@ -0,0 +1,67 @@
+/* Swaps a large anonymous region out and reads it back twice, so that
+ * the second pass evicts pages that still have their copy in swap, then
+ * rewrites it and checks that the new contents, not the stale copies,
+ * come back.  For this test, Pintos memory size is 10MB. */
+
+#include <string.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (16 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunks[CHUNK_SIZE];
+
+/* Byte OFS of page PAGE in generation GEN. */
+static char
+pattern (int gen, size_t page, size_t ofs)
+{
+  uint32_t x = (gen * PAGE_COUNT + page) * PAGE_SIZE + ofs;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return (char) (x * 2654435761u >> 24);
+}
+
+static void
+write_pages (int gen)
+{
+  size_t i, j;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    {
+      char *mem = big_chunks + i * PAGE_SIZE;
+      for (j = 0; j < PAGE_SIZE; j++)
+        mem[j] = pattern (gen, i, j);
+    }
+  msg ("write generation %d", gen);
+}
+
+static void
+check_pages (int gen)
+{
+  size_t i, j;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    {
+      char *mem = big_chunks + i * PAGE_SIZE;
+      for (j = 0; j < PAGE_SIZE; j++)
+        if (mem[j] != pattern (gen, i, j))
+          fail ("byte %zu of page %zu is inconsistent", j, i);
+    }
+  msg ("check generation %d", gen);
+}
+
+void
+test_main (void)
+{
+  write_pages (0);
+  check_pages (0);
+  check_pages (0);
+  write_pages (1);
+  check_pages (1);
+}
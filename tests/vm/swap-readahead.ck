@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-readahead) begin
+(swap-readahead) write generation 0
+(swap-readahead) check generation 0
+(swap-readahead) check generation 0
+(swap-readahead) write generation 1
+(swap-readahead) check generation 1
+(swap-readahead) end
+EOF
+pass;
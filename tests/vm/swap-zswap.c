@@ -0,0 +1,59 @@
+/* Swaps out a mix of compressible and incompressible anonymous pages
+ * with the compressed swap pool enabled, then checks that every page
+ * comes back intact, whether it was kept in the pool or written to the
+ * swap disk.  For this test, Pintos memory size is 10MB. */
+
+#include <string.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (16 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunks[CHUNK_SIZE];
+
+/* Byte OFS of page PAGE.  Even pages repeat a short run, which
+ * compresses well; odd pages are pseudo-random, which does not. */
+static char
+pattern (size_t page, size_t ofs)
+{
+  if (page % 2 == 0)
+    return (char) (page + ofs % 7);
+  else
+    {
+      uint32_t x = page * PAGE_SIZE + ofs;
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      return (char) (x * 2654435761u >> 24);
+    }
+}
+
+void
+test_main (void)
+{
+  size_t i, j;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    {
+      char *mem = big_chunks + i * PAGE_SIZE;
+      if (!(i % 1024))
+        msg ("write page %zu", i);
+      for (j = 0; j < PAGE_SIZE; j++)
+        mem[j] = pattern (i, j);
+    }
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    {
+      char *mem = big_chunks + i * PAGE_SIZE;
+      for (j = 0; j < PAGE_SIZE; j++)
+        if (mem[j] != pattern (i, j))
+          fail ("byte %zu of page %zu is inconsistent", j, i);
+      if (!(i % 1024))
+        msg ("check page %zu", i);
+    }
+}
@@ -0,0 +1,43 @@
+/* Runs a second instance of this program, which checks that its
+   code is in the same physical page as the first instance's:
+   read-only text of one executable is shared between processes. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+int
+main (int argc, char *argv[])
+{
+  void *pa = get_phys_addr ((void *) main);
+  char cmd[64];
+  pid_t child;
+
+  test_name = "text-share";
+
+  if (argc == 2)
+    {
+      /* Second instance: ARGV[1] is the first one's physical
+         address for this code, in decimal. */
+      unsigned long parent_pa = 0;
+      const char *p;
+
+      for (p = argv[1]; *p >= '0' && *p <= '9'; p++)
+        parent_pa = parent_pa * 10 + (*p - '0');
+      CHECK ((void *) parent_pa == pa, "child shares the parent's text");
+      return 0;
+    }
+
+  msg ("begin");
+  CHECK (pa != NULL, "text is mapped");
+  snprintf (cmd, sizeof cmd, "text-share %lu", (unsigned long) pa);
+  child = fork ("text-share");
+  if (child == 0)
+    {
+      exec (cmd);
+      fail ("exec \"%s\" failed", cmd);
+    }
+  CHECK (wait (child) == 0, "wait for child");
+  msg ("end");
+  return 0;
+}
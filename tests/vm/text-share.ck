@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(text-share) begin
+(text-share) text is mapped
+(text-share) child shares the parent's text
+(text-share) wait for child
+(text-share) end
+EOF
+pass;
@@ -0,0 +1,15 @@
+#ifndef TESTS_VM_TSC_H
+#define TESTS_VM_TSC_H
+
+#include <stdint.h>
+
+/* Reads the time-stamp counter. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+#endif /* tests/vm/tsc.h */
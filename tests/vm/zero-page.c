@@ -0,0 +1,40 @@
+/* Reads untouched .bss pages, which should all map one shared
+   zero frame, then writes one of them, which should get it a
+   frame of its own without disturbing the others. */
+
+#include <string.h>
+#include <syscall.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CHUNK_PAGE_COUNT 4
+#define CHUNK_SIZE (CHUNK_PAGE_COUNT * PAGE_SIZE)
+
+static char buf[CHUNK_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+	size_t i;
+	void *pa;
+
+	msg ("read pages");
+	for (i = 0 ; i < CHUNK_PAGE_COUNT ; i++)
+		CHECK (buf[i * PAGE_SIZE] == 0, "check memory content");
+
+	pa = get_phys_addr (&buf[0]);
+	CHECK (pa != 0, "check if page is mapped");
+	for (i = 1 ; i < CHUNK_PAGE_COUNT ; i++)
+		CHECK (get_phys_addr (&buf[i * PAGE_SIZE]) == pa,
+				"check if page shares the zero frame");
+
+	msg ("write page [1]");
+	buf[PAGE_SIZE] = 1;
+	CHECK (get_phys_addr (&buf[PAGE_SIZE]) != pa, "check if page got a frame");
+	CHECK (get_phys_addr (&buf[0]) == pa, "check if page still shares the zero frame");
+	for (i = 0 ; i < CHUNK_PAGE_COUNT ; i++)
+		CHECK (buf[i * PAGE_SIZE] == (i == 1), "check memory content");
+}
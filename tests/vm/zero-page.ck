@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(zero-page) begin
+(zero-page) read pages
+(zero-page) check memory content
+(zero-page) check memory content
+(zero-page) check memory content
+(zero-page) check memory content
+(zero-page) check if page is mapped
+(zero-page) check if page shares the zero frame
+(zero-page) check if page shares the zero frame
+(zero-page) check if page shares the zero frame
+(zero-page) write page [1]
+(zero-page) check if page got a frame
+(zero-page) check if page still shares the zero frame
+(zero-page) check memory content
+(zero-page) check memory content
+(zero-page) check memory content
+(zero-page) check memory content
+(zero-page) end
+EOF
+pass;
@@ -31,6 +31,7 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/zswap.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -221,11 +222,27 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-periodic"))
+			timer_tickless = false;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-fault-around"))
+			vm_fault_around = atoi (value);
+		else if (!strcmp (name, "-zswap"))
+			zswap_pool_pages = atoi (value);
+		else if (!strcmp (name, "-swap"))
+			swap_devices = value;
+		else if (!strcmp (name, "-writeback"))
+			vm_writeback_interval = atoi (value);
+		else if (!strcmp (name, "-huge-pages"))
+			vm_huge_pages = true;
+		else if (!strcmp (name, "-ksm"))
+			vm_ksm_interval = atoi (value);
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -326,8 +343,18 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -periodic          Take every timer tick, even when idle; by default\n"
+			"                     idle ticks are skipped, up to 5 at a time.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -fault-around=N    Load up to N more pages of a file on a read fault.\n"
+			"  -zswap=PAGES       Keep up to PAGES of compressed swap in memory.\n"
+			"  -swap=C:D[:P],...  Swap to disks C:D, higher priorities P first.\n"
+			"  -writeback=TICKS   Write back dirty mapped pages every TICKS ticks.\n"
+			"  -huge-pages        Back large zero-fill regions with 2 MB pages.\n"
+			"  -ksm=TICKS         Merge identical anonymous pages every TICKS ticks.\n"
 #endif
 			);
 	power_off ();
@@ -362,4 +389,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+#endif
 }
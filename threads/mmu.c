@@ -23,6 +23,9 @@ pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 			} else
 				return NULL;
 		}
+		/* A huge page has no page table: its PDE is the leaf. */
+		if (pdp[idx] & PTE_PS)
+			return &pdp[idx];
 		return (uint64_t *) ptov (PTE_ADDR (pdp[idx]) + 8 * PTX (va));
 	}
 	return NULL;
@@ -88,6 +91,31 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	return pte;
 }
 
+/* Returns the address of the page directory entry for virtual
+ * address VA in PML4.  Missing tables above the page directory
+ * are created if CREATE is true; otherwise, or if memory runs
+ * out, a null pointer is returned. */
+static uint64_t *
+pde_walk (uint64_t *pml4, const uint64_t va, int create) {
+	uint64_t *entry = &pml4[PML4 (va)];
+	int level;
+
+	for (level = 0; level < 2; level++) {
+		uint64_t *table;
+
+		if (!(*entry & PTE_P)) {
+			uint64_t *new_page;
+
+			if (!create || (new_page = palloc_get_page (PAL_ZERO)) == NULL)
+				return NULL;
+			*entry = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+		}
+		table = ptov (PTE_ADDR (*entry));
+		entry = &table[level == 0 ? PDPE (va) : PDX (va)];
+	}
+	return entry;
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -122,10 +150,18 @@ pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
-					pml4_index, pdp_index, i))
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS) {
+			/* A huge page: FUNC sees its PDE once. */
+			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
+								 ((uint64_t) pdp_index << PDPESHIFT) |
+								 ((uint64_t) i << PDXSHIFT));
+			if (!func (&pdp[i], va, aux))
 				return false;
+		} else if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
+					pml4_index, pdp_index, i))
+			return false;
 	}
 	return true;
 }
@@ -169,7 +205,11 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS)
+			palloc_free_multiple ((void *) PTE_ADDR (pte), HUGE_PAGES);
+		else
 			pt_destroy (PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pdp);
@@ -216,6 +256,8 @@ pml4_get_page (uint64_t *pml4, const void *uaddr) {
 
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
+	if (pte && (*pte & PTE_P) && (*pte & PTE_PS))
+		return ptov (PTE_ADDR (*pte)) + ((uint64_t) uaddr & (HUGE_PGSIZE - 1));
 	if (pte && (*pte & PTE_P))
 		return ptov (PTE_ADDR (*pte)) + pg_ofs (uaddr);
 	return NULL;
@@ -238,11 +280,82 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) upage, 1);
 
-	if (pte)
+	if (pte) {
+		ASSERT (!(*pte & PTE_PS));
 		*pte = vtop (kpage) | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+	}
 	return pte != NULL;
 }
 
+/* Maps the HUGE_PGSIZE bytes at user virtual address UPAGE in
+ * PML4 to the physically contiguous frame at kernel virtual
+ * address KPAGE, with a single page directory entry.  Both must
+ * be HUGE_PGSIZE aligned.  An empty page table that used to map
+ * the range is freed.  Returns false if memory allocation failed
+ * or some base page in the range is still mapped. */
+bool
+pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	ASSERT (((uint64_t) upage & (HUGE_PGSIZE - 1)) == 0);
+	ASSERT ((vtop (kpage) & (HUGE_PGSIZE - 1)) == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage, 1);
+
+	if (pde == NULL)
+		return false;
+	if (*pde & PTE_P) {
+		uint64_t *pt = ptov (PTE_ADDR (*pde));
+
+		ASSERT (!(*pde & PTE_PS));
+		for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++)
+			if (pt[i] & PTE_P)
+				return false;
+		palloc_free_page (pt);
+	}
+	*pde = vtop (kpage) | PTE_P | PTE_PS | (rw ? PTE_W : 0) | PTE_U;
+	if (rcr3 () == vtop (pml4))
+		invlpg ((uint64_t) upage);
+	return true;
+}
+
+/* Replaces the huge page mapped at UPAGE in PML4 with a page
+ * table that maps the same frame a base page at a time.  Each
+ * PTE inherits the permissions and the accessed and dirty bits
+ * of the PDE.  Returns false if memory allocation failed. */
+bool
+pml4_split_huge_page (uint64_t *pml4, void *upage) {
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage, 0);
+	uint64_t *pt, paddr, flags;
+
+	ASSERT (pde != NULL && (*pde & PTE_P) && (*pde & PTE_PS));
+
+	pt = palloc_get_page (0);
+	if (pt == NULL)
+		return false;
+	paddr = PTE_ADDR (*pde);
+	flags = *pde & PTE_FLAGS & ~(uint64_t) PTE_PS;
+	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++)
+		pt[i] = (paddr + i * PGSIZE) | flags;
+	*pde = vtop (pt) | PTE_U | PTE_W | PTE_P;
+	if (rcr3 () == vtop (pml4))
+		invlpg ((uint64_t) upage);
+	return true;
+}
+
+/* Marks the huge page mapped at UPAGE in PML4 "not present", so
+ * that pml4_destroy() leaves its frame alone. */
+void
+pml4_clear_huge_page (uint64_t *pml4, void *upage) {
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage, 0);
+
+	ASSERT (pde != NULL && (*pde & PTE_P) && (*pde & PTE_PS));
+
+	*pde &= ~PTE_P;
+	if (rcr3 () == vtop (pml4))
+		invlpg ((uint64_t) upage);
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
@@ -256,6 +369,7 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 	pte = pml4e_walk (pml4, (uint64_t) upage, false);
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
+		ASSERT (!(*pte & PTE_PS));
 		*pte &= ~PTE_P;
 		if (rcr3 () == vtop (pml4))
 			invlpg ((uint64_t) upage);
@@ -284,6 +284,40 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	return pages;
 }
 
+/* Like palloc_get_multiple(), but the physical address of the
+   first page is a multiple of ALIGN pages, as a huge page
+   needs. */
+void *
+palloc_get_multiple_aligned (enum palloc_flags flags, size_t page_cnt,
+		size_t align) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	void *pages = NULL;
+	size_t page_idx;
+
+	ASSERT (align > 0);
+
+	lock_acquire (&pool->lock);
+	page_idx = (align - pg_no (vtop (pool->base)) % align) % align;
+	for (; page_idx + page_cnt <= bitmap_size (pool->used_map);
+			page_idx += align)
+		if (bitmap_none (pool->used_map, page_idx, page_cnt)) {
+			bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+			pages = pool->base + PGSIZE * page_idx;
+			break;
+		}
+	lock_release (&pool->lock);
+
+	if (pages) {
+		if (flags & PAL_ZERO)
+			memset (pages, 0, PGSIZE * page_cnt);
+	} else {
+		if (flags & PAL_ASSERT)
+			PANIC ("palloc_get: out of pages");
+	}
+
+	return pages;
+}
+
 /* Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
@@ -31,6 +31,7 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
 
 /* Add */
 bool cond_high_priority (const struct list_elem *a, const struct list_elem *b, void *aux);
@@ -79,6 +80,62 @@ sema_down (struct semaphore *sema) {
 	intr_set_level (old_level);
 }
 
+/* A thread waiting in sema_down_timeout(). */
+struct sema_waiter {
+	struct thread *thread;              /* The waiting thread. */
+	bool timed_out;                     /* Woken by the timeout? */
+};
+
+/* Timeout function of sema_down_timeout(): wakes up the waiter W_
+   if it is still blocked on the semaphore.  Once sema_up() has
+   unblocked it, it cannot block again before it cancels the
+   timeout. */
+static void
+sema_timeout_expire (void *w_) {
+	struct sema_waiter *w = w_;
+
+	if (w->thread->status == THREAD_BLOCKED) {
+		w->timed_out = true;
+		list_remove (&w->thread->elem);
+		thread_unblock (w->thread);
+	}
+}
+
+/* Down or "P" operation on a semaphore that gives up after TICKS
+   timer ticks.  Returns true if SEMA was decremented, false if the
+   time ran out first.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool
+sema_down_timeout (struct semaphore *sema, int64_t ticks) {
+	struct sema_waiter w;
+	struct timeout to;
+	enum intr_level old_level;
+	bool success = false;
+
+	ASSERT (sema != NULL);
+	ASSERT (!intr_context ());
+
+	w.thread = thread_current ();
+	w.timed_out = false;
+	timeout_init (&to, sema_timeout_expire, &w);
+
+	old_level = intr_disable ();
+	timeout_arm (&to, timer_ticks () + ticks);
+	while (sema->value == 0 && !w.timed_out) {
+		list_insert_ordered (&sema->waiters, &thread_current ()->elem, sema_high_priority, NULL);
+		thread_block ();
+	}
+	timeout_cancel (&to);
+	if (sema->value > 0) {
+		sema->value--;
+		success = true;
+	}
+	intr_set_level (old_level);
+	return success;
+}
+
 /* Down or "P" operation on a semaphore, but only if the
    semaphore is not already 0.  Returns true if the semaphore is
    decremented, false otherwise.
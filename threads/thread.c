@@ -12,6 +12,7 @@
 #include "threads/vaddr.h"
 #include "intrinsic.h"
 #include "threads/fixed_point.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -25,9 +26,14 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running: one FIFO queue per
+   priority, with bit P of ready_mask set while queue P is not
+   empty, so that finding the highest ready priority takes a single
+   count-leading-zeros instead of a walk over the ready threads. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static size_t ready_cnt;        /* # of threads in ready_queues. */
 static struct list all_list;
 
 /* Idle thread. */
@@ -59,8 +65,21 @@ void mlfqs_recent_cpu(struct thread *t);
 void mlfqs_load_avg();
 void mlfqs_recalculate_priority();
 void mlfqs_recalculate_recent_cpu();
+static void mlfqs_mark_dirty(struct thread *t);
 int load_avg;
 
+/* The MLFQS recomputes only what has changed.  Between the
+   once-a-second decays, recent_cpu changes only for threads that
+   run, which mlfqs_incr() puts on mlfqs_dirty_list for the next
+   priority pass.  The decay itself is applied at once only to the
+   running and ready threads; a blocked thread applies the decays it
+   missed, from decay_coef, when it is unblocked. */
+#define DECAY_HISTORY 64        /* # of decay coefficients kept. */
+static int decay_coef[DECAY_HISTORY]; /* Coefficient of decay E, at
+                                   E % DECAY_HISTORY. */
+static int64_t decay_epoch;     /* # of decays so far. */
+static struct list mlfqs_dirty_list;
+
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
@@ -78,6 +97,11 @@ static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule (void);
 static tid_t allocate_tid (void);
+static void ready_push (struct thread *);
+static void ready_remove (struct thread *);
+static struct thread *ready_pop (void);
+static int ready_max_priority (void);
+static void ready_requeue (struct thread *);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -123,16 +147,15 @@ thread_init (void) {
 
 	/* Init the globla thread context */
 	lock_init (&tid_lock);
-	list_init (&ready_list);
+	for (int i = PRI_MIN; i <= PRI_MAX; i++)
+		list_init (&ready_queues[i]);
 	list_init (&destruction_req);
 	list_init (&all_list);
+	list_init (&mlfqs_dirty_list);
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
 	init_thread (initial_thread, "main", PRI_DEFAULT);
-
-	if (thread_mlfqs)
-		list_push_back(&all_list, &(initial_thread->all_elem));
 	initial_thread->status = THREAD_RUNNING;
 	initial_thread->tid = allocate_tid ();
 }
@@ -168,7 +191,7 @@ thread_tick (void) {
 
 	/* Enforce preemption. */
 	if (++thread_ticks >= TIME_SLICE){
-		if (!list_empty(&ready_list)) {
+		if (ready_cnt > 0) {
 			intr_yield_on_return ();
 		}
 	}
@@ -279,8 +302,11 @@ thread_unblock (struct thread *t) {
 
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
-	// list_push_back (&ready_list, &t->elem);
-	list_insert_ordered (&ready_list, &t->elem, high_priority, NULL);
+	if (thread_mlfqs && t->decay_epoch != decay_epoch) {
+		mlfqs_recent_cpu(t);
+		mlfqs_priority(t);
+	}
+	ready_push (t);
 	t->status = THREAD_READY;
 
 	intr_set_level (old_level);
@@ -325,16 +351,31 @@ thread_exit (void) {
 #ifdef USERPROG
 	process_exit ();
 #endif
-	if (thread_mlfqs)
-        list_remove(&thread_current()->all_elem);
-
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
+	list_remove (&thread_current ()->all_elem);
+	if (thread_current ()->mlfqs_dirty)
+		list_remove (&thread_current ()->mlfqs_elem);
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
 
+/* Invokes FUNC on all threads, passing along AUX.
+   This function must be called with interrupts off. */
+void
+thread_foreach (thread_action_func *func, void *aux) {
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (e = list_begin (&all_list); e != list_end (&all_list);
+			e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, all_elem);
+		func (t, aux);
+	}
+}
+
 /* Yields the CPU.  The current thread is not put to sleep and
    may be scheduled again immediately at the scheduler's whim. */
 void
@@ -346,8 +387,7 @@ thread_yield (void) {
 
 	old_level = intr_disable ();
 	if (curr != idle_thread)
-		// list_push_back (&ready_list, &curr->elem);
-		list_insert_ordered (&ready_list, &curr->elem, high_priority, NULL);
+		ready_push (curr);
 	do_schedule (THREAD_READY);
 	intr_set_level (old_level);
 }
@@ -442,6 +482,10 @@ idle (void *idle_started_ UNUSED) {
 		intr_disable ();
 		thread_block ();
 
+		/* Nothing is ready to run, so the timer need not interrupt
+		   until the next tick with work due. */
+		timer_idle_enter ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -473,6 +517,8 @@ kernel_thread (thread_func *function, void *aux) {
    NAME. */
 static void
 init_thread (struct thread *t, const char *name, int priority) {
+	enum intr_level old_level;
+
 	ASSERT (t != NULL);
 	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
 	ASSERT (name != NULL);
@@ -482,12 +528,13 @@ init_thread (struct thread *t, const char *name, int priority) {
 	strlcpy (t->name, name, sizeof t->name);
 	t->tf.rsp = (uint64_t) t + PGSIZE - sizeof (void *);
 
-	if (thread_mlfqs) {
+	if (thread_mlfqs)
 		mlfqs_priority(t);
-		list_push_back(&all_list, &t->all_elem);
-	} else {
+	else
 		t->priority = priority;
-	}
+	old_level = intr_disable ();
+	list_push_back (&all_list, &t->all_elem);
+	intr_set_level (old_level);
 
 	t->magic = THREAD_MAGIC;
 
@@ -496,6 +543,7 @@ init_thread (struct thread *t, const char *name, int priority) {
 
 	t->nice = 0;
 	t->recent_cpu = 0;
+	t->decay_epoch = decay_epoch;
 	t->next_fd = 3;	//(oom_update)
 // #ifdef USERPROG
 	sema_init(&t->fork_sema, 0);
@@ -513,10 +561,66 @@ init_thread (struct thread *t, const char *name, int priority) {
    idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
+	if (ready_cnt == 0)
 		return idle_thread;
 	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+		return ready_pop ();
+}
+
+/* Appends T to the ready queue for its priority. */
+static void
+ready_push (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	t->ready_pri = t->priority;
+	list_push_back (&ready_queues[t->ready_pri], &t->elem);
+	ready_mask |= 1ULL << t->ready_pri;
+	ready_cnt++;
+}
+
+/* Removes T, a ready thread, from its ready queue. */
+static void
+ready_remove (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	list_remove (&t->elem);
+	if (list_empty (&ready_queues[t->ready_pri]))
+		ready_mask &= ~(1ULL << t->ready_pri);
+	ready_cnt--;
+}
+
+/* Returns the highest priority of a ready thread.  There must be
+   one. */
+static int
+ready_max_priority (void) {
+	ASSERT (ready_mask != 0);
+	return 63 - __builtin_clzll (ready_mask);
+}
+
+/* Removes and returns the first thread of the highest non-empty
+   ready queue.  There must be one. */
+static struct thread *
+ready_pop (void) {
+	struct thread *t = list_entry (
+			list_front (&ready_queues[ready_max_priority ()]),
+			struct thread, elem);
+
+	ready_remove (t);
+	return t;
+}
+
+/* Moves T to the ready queue for its priority, if T is ready and its
+   priority has changed since it was queued. */
+static void
+ready_requeue (struct thread *t) {
+	enum intr_level old_level = intr_disable ();
+
+	if (t->status == THREAD_READY && t->ready_pri != t->priority) {
+		ready_remove (t);
+		ready_push (t);
+	}
+	intr_set_level (old_level);
 }
 
 /* Use iretq to launch the thread */
@@ -647,6 +751,10 @@ schedule (void) {
 	/* Start new time slice. */
 	thread_ticks = 0;
 
+	/* Count the ticks skipped while idle before anyone reads them. */
+	if (curr == idle_thread)
+		timer_idle_exit ();
+
 #ifdef USERPROG
 	/* Activate the new address space. */
 	process_activate (next);
@@ -685,12 +793,10 @@ allocate_tid (void) {
 }
 
 void check_priority() {
-	if (list_empty(&ready_list))
+	if (ready_cnt == 0)
 		return;
 
-	struct thread *t = list_entry(list_front(&ready_list), struct thread, elem);
-
-	if (thread_current()->priority < t->priority) {
+	if (thread_current()->priority < ready_max_priority()) {
 		if (intr_context())
 			intr_yield_on_return();
 		else
@@ -709,14 +815,11 @@ void print_ready_list(void) {
 	struct thread *t = thread_current();
 
 	printf("\n################################# Running Thread name: %s, Priority: %d, Thread: %d\n", t->name, t->priority, t->tid);
-	for (e = list_begin(&ready_list); e != list_end(&ready_list); e = list_next(e)) {
-		struct thread *t = (t = list_entry(e, struct thread, elem)) != NULL ? t : NULL;
-		if (t != NULL) {
+	for (int pri = PRI_MAX; pri >= PRI_MIN; pri--)
+		for (e = list_begin(&ready_queues[pri]); e != list_end(&ready_queues[pri]); e = list_next(e)) {
+			struct thread *t = list_entry(e, struct thread, elem);
 			printf("##################################### Thread name: %s, Priority: %d, Thread: %d\n", t->name, t->priority, t->tid);
-		} else {
-			printf("Invalid thread or priority.\n");
 		}
-	}
 	printf("----------------\n");
 }
 
@@ -730,8 +833,10 @@ void donate_priority() {
 		struct thread *now_t = now_wait_on_lock->holder;
 		struct thread *don_t = list_entry(list_front(&now_t->donations), struct thread, donation_elem);
 
-		if (now_t->priority < don_t->priority)
+		if (now_t->priority < don_t->priority) {
 			now_t->priority = don_t->priority;
+			ready_requeue(now_t);
+		}
 		now_wait_on_lock = now_t->wait_on_lock;
 	}
 }
@@ -778,46 +883,78 @@ void mlfqs_priority(struct thread *t) {
 	t->priority = new_priority;
 }
 
+/* Applies to T the decays of recent_cpu it has missed.  Decays older
+   than DECAY_HISTORY use the oldest coefficient kept, until recent_cpu
+   stops changing. */
 void mlfqs_recent_cpu(struct thread *t) {
 	if (t == idle_thread) {
 		return;
 	}
-	int temp = div_fp(mult_mixed(load_avg, 2), add_mixed(mult_mixed(load_avg, 2), 1));
-	t->recent_cpu = add_mixed(mult_fp(temp, t->recent_cpu), t->nice);
+	while (t->decay_epoch < decay_epoch) {
+		int64_t oldest = decay_epoch - DECAY_HISTORY;
+		int64_t epoch = t->decay_epoch > oldest ? t->decay_epoch : oldest;
+		int recent_cpu = add_mixed(mult_fp(decay_coef[epoch % DECAY_HISTORY], t->recent_cpu), t->nice);
+
+		if (t->decay_epoch < oldest && recent_cpu == t->recent_cpu)
+			t->decay_epoch = oldest;
+		else
+			t->decay_epoch++;
+		t->recent_cpu = recent_cpu;
+	}
 }
 
 void mlfqs_load_avg() {
-	int ready_list_size = list_size(&ready_list);
+	int ready_list_size = ready_cnt;
 	if (thread_current() != idle_thread){
 		ready_list_size += 1;
 	}
 	load_avg =  add_fp (mult_fp (div_fp (int_to_fp (59), int_to_fp (60)), load_avg), mult_mixed (div_fp (int_to_fp (1), int_to_fp (60)), ready_list_size));
 }
 
+/* Recomputes the priority of the threads whose recent_cpu changed
+   since the last pass. */
 void mlfqs_recalculate_priority() {
 	enum intr_level old_level = intr_disable();
-	for (struct list_elem *e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
-		struct thread *t = list_entry(e, struct thread, all_elem);
-		if (t == idle_thread) {
-			continue;
-		}
+	while (!list_empty(&mlfqs_dirty_list)) {
+		struct thread *t = list_entry(list_pop_front(&mlfqs_dirty_list), struct thread, mlfqs_elem);
+		t->mlfqs_dirty = false;
 		mlfqs_priority(t);
+		ready_requeue(t);
 	}
 	intr_set_level(old_level);
 }
 
+/* Decays recent_cpu once a second: at once for the running and ready
+   threads, and for blocked threads when thread_unblock() runs them
+   again. */
 void mlfqs_recalculate_recent_cpu() {
 	enum intr_level old_level = intr_disable();
-	for (struct list_elem *e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
-		struct thread *t = list_entry(e, struct thread, all_elem);
-		if (t == idle_thread) {
-			continue;
-		}
-		mlfqs_recent_cpu(t);
+	struct thread *curr = thread_current();
+
+	decay_coef[decay_epoch % DECAY_HISTORY] = div_fp(mult_mixed(load_avg, 2), add_mixed(mult_mixed(load_avg, 2), 1));
+	decay_epoch++;
+
+	if (curr != idle_thread) {
+		mlfqs_recent_cpu(curr);
+		mlfqs_mark_dirty(curr);
 	}
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		for (struct list_elem *e = list_begin(&ready_queues[pri]); e != list_end(&ready_queues[pri]); e = list_next(e)) {
+			struct thread *t = list_entry(e, struct thread, elem);
+			mlfqs_recent_cpu(t);
+			mlfqs_mark_dirty(t);
+		}
 	intr_set_level(old_level);
 }
 
+/* Queues T for the next priority pass. */
+static void mlfqs_mark_dirty(struct thread *t) {
+	if (!t->mlfqs_dirty) {
+		t->mlfqs_dirty = true;
+		list_push_back(&mlfqs_dirty_list, &t->mlfqs_elem);
+	}
+}
+
 void mlfqs_incr(){
 	struct thread *t = thread_current();
 	if (t == idle_thread){
@@ -825,6 +962,7 @@ void mlfqs_incr(){
 	}
 	int curr_recent_cpu = t->recent_cpu;
 	t->recent_cpu = add_mixed(curr_recent_cpu,1);
+	mlfqs_mark_dirty(t);
 }
 
 struct thread *get_thread_by_tid(tid_t tid) {
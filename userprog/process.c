@@ -13,6 +13,7 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -30,6 +31,7 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void __do_spawn (void *);
 
 /* General process initializer for initd and other process. */
 // static void
@@ -191,8 +193,12 @@ __do_fork (void *aux) {
 
 	process_activate (curr);
 #ifdef VM
-	supplemental_page_table_init (&current->spt);
-	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
+	supplemental_page_table_init (&curr->spt);
+	curr->rss_soft_limit = parent->rss_soft_limit;
+	curr->rss_hard_limit = parent->rss_hard_limit;
+	curr->oom_score_adj = parent->oom_score_adj;
+	curr->stack_limit = parent->stack_limit;
+	if (!supplemental_page_table_copy (&curr->spt, &parent->spt))
 		goto error;
 #else
 	if (!pml4_for_each (parent->pml4, duplicate_pte, parent))
@@ -220,6 +226,119 @@ error:
 	exit (-1);
 }
 
+/* What process_spawn() hands the new process. */
+struct spawn_info {
+	char *cmd_line;                     /* Page holding the command line. */
+	struct thread *parent;
+	struct file *files[SPAWN_ACTIONS_MAX];  /* Duplicates of the parent's. */
+	int fds[SPAWN_ACTIONS_MAX];         /* Descriptor for each of FILES. */
+	size_t file_cnt;
+	bool success;                       /* Did the program load? */
+};
+
+/* Starts a new process running CMD_LINE, a page that the new process
+ * frees, without duplicating the current process's address space: the
+ * child is loaded straight from its executable.  It inherits only the
+ * ACTION_CNT descriptors in ACTIONS, which must be open in the current
+ * process.  Returns the new process's thread id once it has loaded, or
+ * TID_ERROR if it cannot be created or loaded. */
+tid_t
+process_spawn (char *cmd_line, const struct spawn_fd_action *actions,
+		size_t action_cnt) {
+	struct thread *curr = thread_current ();
+	struct spawn_info info;
+	char name[sizeof curr->name];
+	struct thread *child;
+	tid_t child_tid;
+	size_t i;
+
+	ASSERT (action_cnt <= SPAWN_ACTIONS_MAX);
+
+	info.cmd_line = cmd_line;
+	info.parent = curr;
+	info.success = false;
+	for (info.file_cnt = 0; info.file_cnt < action_cnt; info.file_cnt++) {
+		const struct spawn_fd_action *action = &actions[info.file_cnt];
+		struct file *file = file_duplicate (curr->fd_table[action->parent_fd]);
+
+		if (file == NULL)
+			goto error;
+		info.files[info.file_cnt] = file;
+		info.fds[info.file_cnt] = action->child_fd;
+	}
+
+	/* Name the process after its program. */
+	strlcpy (name, cmd_line, sizeof name);
+	name[strcspn (name, " ")] = '\0';
+
+	child_tid = thread_create (name, PRI_DEFAULT, __do_spawn, &info);
+	if (child_tid == TID_ERROR)
+		goto error;
+	child = get_thread_by_tid (child_tid);
+	if (child == NULL)
+		return TID_ERROR;
+
+	/* The child owns the page and the files from here on. */
+	sema_down (&child->fork_sema);
+	if (!info.success) {
+		list_remove (&child->child_elem);
+		sema_up (&child->free_sema);
+		return TID_ERROR;
+	}
+	return child_tid;
+
+error:
+	for (i = 0; i < info.file_cnt; i++)
+		file_close (info.files[i]);
+	palloc_free_page (cmd_line);
+	return TID_ERROR;
+}
+
+/* A thread function that loads the program of a process_spawn(). */
+static void
+__do_spawn (void *aux) {
+	struct spawn_info *info = aux;
+	struct thread *curr = thread_current ();
+	struct intr_frame if_;
+	size_t i;
+
+	memset (&if_, 0, sizeof if_);
+	if_.ds = if_.es = if_.ss = SEL_UDSEG;
+	if_.cs = SEL_UCSEG;
+	if_.eflags = FLAG_IF | FLAG_MBS;
+
+#ifdef VM
+	supplemental_page_table_init (&curr->spt);
+	curr->rss_soft_limit = info->parent->rss_soft_limit;
+	curr->rss_hard_limit = info->parent->rss_hard_limit;
+	curr->oom_score_adj = info->parent->oom_score_adj;
+	curr->stack_limit = info->parent->stack_limit;
+#endif
+	for (i = 0; i < info->file_cnt; i++) {
+		struct file **slot = &curr->fd_table[info->fds[i]];
+
+		/* The last action for a descriptor wins. */
+		if (*slot != NULL)
+			file_close (*slot);
+		*slot = info->files[i];
+	}
+
+	lock_acquire (&syscall_lock);
+	info->success = load (info->cmd_line, &if_);
+	lock_release (&syscall_lock);
+	palloc_free_page (info->cmd_line);
+
+	/* INFO belongs to the parent, which may go on once we signal. */
+	if (!info->success) {
+		sema_up (&curr->fork_sema);
+		exit (-1);
+	}
+	sema_up (&curr->fork_sema);
+	process_init ();
+	do_iret (&if_);
+	NOT_REACHED ();
+}
+
 /* Switch the current execution context to the f_name.
  * Returns -1 on fail. */
 // 단순히 프로그램 파일 이름만을 인자로 받아오게 하는 대신
@@ -716,9 +835,18 @@ install_page (void *upage, void *kpage, bool writable) {
 
 static bool
 lazy_load_segment (struct page *page, void *aux) {
-	/* TODO: Load the segment from the file */
-	/* TODO: This called when the first page fault occurs on address VA. */
-	/* TODO: VA is available when calling this function. */
+	struct lazy_load_info *info = aux;
+	void *kva = page->frame->kva;
+	bool success;
+
+	success = file_read_at (info->file, kva, info->read_bytes, info->ofs)
+		== (off_t) info->read_bytes;
+	if (success)
+		memset (kva + info->read_bytes, 0, PGSIZE - info->read_bytes);
+
+	file_close (info->file);
+	free (info);
+	return success;
 }
 
 /* Loads a segment starting at offset OFS in FILE at address
@@ -742,6 +870,8 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (ofs % PGSIZE == 0);
 
+	if (!vm_reserve (upage, read_bytes + zero_bytes))
+		return false;
 	while (read_bytes > 0 || zero_bytes > 0) {
 		/* Do calculate how to fill this page.
 		 * We will read PAGE_READ_BYTES bytes from FILE
@@ -749,30 +879,53 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		void *aux = NULL;
-		if (!vm_alloc_page_with_initializer (VM_ANON, upage,
-					writable, lazy_load_segment, aux))
-			return false;
+		if (page_read_bytes == 0) {
+			/* Nothing to read: an ordinary zero-filled page will do. */
+			if (!vm_alloc_page (VM_ANON, upage, writable))
+				return false;
+		} else {
+			struct lazy_load_info *info = malloc (sizeof *info);
+			if (info == NULL)
+				return false;
+			info->file = file_reopen (file);
+			info->ofs = ofs;
+			info->read_bytes = page_read_bytes;
+			/* Read-only pages stay backed by the executable, so that
+			 * every process running it can share them. */
+			if (info->file == NULL
+					|| !(writable
+						? vm_alloc_page_with_initializer (VM_ANON, upage,
+							writable, lazy_load_segment, info)
+						: vm_alloc_page_with_initializer (VM_FILE | VM_TEXT,
+							upage, writable, file_lazy_load, info))) {
+				file_close (info->file);
+				free (info);
+				return false;
+			}
+		}
 
 		/* Advance. */
 		read_bytes -= page_read_bytes;
 		zero_bytes -= page_zero_bytes;
 		upage += PGSIZE;
+		ofs += page_read_bytes;
 	}
 	return true;
 }
 
-/* Create a PAGE of stack at the USER_STACK. Return true on success. */
+/* Create a PAGE of stack at the USER_STACK, in an area that the stack
+ * grows down into as far as the process's stack limit allows.  Return
+ * true on success. */
 static bool
 setup_stack (struct intr_frame *if_) {
 	bool success = false;
 	void *stack_bottom = (void *) (((uint8_t *) USER_STACK) - PGSIZE);
 
-	/* TODO: Map the stack on stack_bottom and claim the page immediately.
-	 * TODO: If success, set the rsp accordingly.
-	 * TODO: You should mark the page is stack. */
-	/* TODO: Your code goes here */
+	if (vm_setup_stack ((void *) USER_STACK, thread_current ()->stack_limit)
+			&& vm_claim_page (stack_bottom)) {
+		if_->rsp = USER_STACK;
+		success = true;
+	}
 
 	return success;
 }
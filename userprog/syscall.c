@@ -14,6 +14,7 @@
 #include "threads/palloc.h"
 
 #include "threads/synch.h"
+#include "devices/timer.h"
 #include <string.h>
 
 typedef uint32_t disk_sector_t;
@@ -85,6 +86,10 @@ syscall_handler (struct intr_frame *f UNUSED) {
 	uint64_t arg4 = f->R.r10;
 	uint64_t arg5 = f->R.r8;
 	uint64_t arg6 = f->R.r9;
+#ifdef VM
+	/* The stack may grow on the first touch of a user buffer. */
+	thread_current()->user_rsp = (void *) f->rsp;
+#endif
 	switch (f->R.rax)
 	{
 		case SYS_HALT:							//  0 운영체제 종료
@@ -152,10 +157,46 @@ syscall_handler (struct intr_frame *f UNUSED) {
 			// printf("SYS_CLOSE\n");
 			close(arg1);
 			break;
+		case SYS_SPAWN:							//  28 새 프로그램으로 자식 프로세스 생성
+			user_memory_valid((void *)arg1);
+			f->R.rax = spawn((const char *) arg1,
+					(const struct spawn_fd_action *) arg2);
+			break;
+		case SYS_CLOCK_NS:						//  31 부팅 이후 나노초 단위 시각
+			f->R.rax = clock_ns();
+			break;
+#ifdef VM
+		case SYS_MMAP:							//  14 파일을 메모리에 매핑
+			f->R.rax = (uint64_t) mmap((void *) arg1, arg2, arg3, arg4, arg5);
+			break;
+		case SYS_MUNMAP:						//  15 메모리 매핑 해제
+			munmap((void *) arg1);
+			break;
+		case SYS_RSS_LIMIT:						//  25 상주 페이지 수 제한
+			f->R.rax = rss_limit(arg1, arg2);
+			break;
+		case SYS_MADVISE:						//  26 메모리 사용 방식 힌트
+			f->R.rax = madvise((void *) arg1, arg2, arg3);
+			break;
+		case SYS_OOM_SCORE_ADJ:					//  27 OOM 희생자 선택 조정
+			f->R.rax = oom_score_adj(arg1);
+			break;
+		case SYS_STACK_LIMIT:					//  29 다음 exec의 스택 크기 제한
+			f->R.rax = stack_limit(arg1);
+			break;
+		case SYS_MSYNC:							//  30 매핑의 변경 내용을 파일에 기록
+			f->R.rax = msync((void *) arg1, arg2);
+			break;
+#endif
 		default:
 			// printf("default;\n");
 			break;
 	}
+#ifdef VM
+	/* The OOM killer chose us while we were in the kernel. */
+	if (thread_current()->oom_killed)
+		exit(-1);
+#endif
 	// printf("-------------------------------\n\n");
 }
 
@@ -165,6 +206,10 @@ void halt (void){
 
 void exit (int status){
 	struct thread *curr = thread_current();
+	/* A fault on a user buffer may kill us in the middle of a file
+	 * system call. */
+	if (lock_held_by_current_thread(&syscall_lock))
+		lock_release(&syscall_lock);
 	curr->process_status = status;
 	printf("%s: exit(%d)\n", curr->name, status);
 	thread_exit();
@@ -186,6 +231,38 @@ int exec (const char *cmd_line){
 	NOT_REACHED();
 }
 
+/* Starts a process running CMD_LINE without copying the caller's address
+ * space.  The new process gets only the descriptors listed in
+ * FD_ACTIONS, which may be null, besides the console. */
+pid_t spawn (const char *cmd_line, const struct spawn_fd_action *fd_actions){
+	struct spawn_fd_action actions[SPAWN_ACTIONS_MAX];
+	size_t cnt = 0;
+	char *copy;
+
+	for (; fd_actions != NULL; cnt++) {
+		user_memory_valid((void *) &fd_actions[cnt]);
+		user_memory_valid((void *) (&fd_actions[cnt] + 1) - 1);
+		if (fd_actions[cnt].parent_fd == -1)
+			break;
+		if (cnt == SPAWN_ACTIONS_MAX
+				|| get_file_by_descriptor(fd_actions[cnt].parent_fd) == NULL
+				|| fd_actions[cnt].child_fd < 3
+				|| fd_actions[cnt].child_fd >= FD_MAX)
+			return -1;
+		actions[cnt] = fd_actions[cnt];
+	}
+
+	copy = palloc_get_page(PAL_ZERO);
+	if (copy == NULL)
+		return -1;
+	strlcpy(copy, cmd_line, PGSIZE);
+	return process_spawn(copy, actions, cnt);
+}
+
+int64_t clock_ns (void){
+	return timer_ns();
+}
+
 int wait (pid_t pid){
 	return process_wait(pid);
 }
@@ -318,13 +395,81 @@ void close (int fd){	//(oom_update)
 	file_close(f);
 }
 
+#ifdef VM
+void *mmap (void *addr, size_t length, int writable, int fd, off_t offset){
+	struct file *file = get_file_by_descriptor(fd);
+
+	/* The mapping must be page-aligned, non-empty, start at a valid file
+	 * offset and lie entirely in user space; do_mmap() checks that it
+	 * overlaps nothing. */
+	if (file == NULL || addr == NULL || pg_ofs(addr) != 0
+			|| offset < 0 || offset % PGSIZE != 0 || length == 0
+			|| !is_user_vaddr(addr)
+			|| length > (uint64_t) KERN_BASE - (uint64_t) addr)
+		return NULL;
+
+	lock_acquire(&syscall_lock);
+	void *mapped = do_mmap(addr, length, writable, file, offset);
+	lock_release(&syscall_lock);
+	return mapped;
+}
+
+void munmap (void *addr){
+	lock_acquire(&syscall_lock);
+	do_munmap(addr);
+	lock_release(&syscall_lock);
+}
+
+size_t rss_limit (size_t soft, size_t hard){
+	return vm_rss_limit(soft, hard);
+}
+
+int oom_score_adj (int adj){
+	return vm_oom_score_adj(adj);
+}
+
+size_t stack_limit (size_t limit){
+	return vm_stack_limit(limit);
+}
+
+int madvise (void *addr, size_t length, int advice){
+	if (addr == NULL || pg_ofs(addr) != 0 || !is_user_vaddr(addr)
+			|| length > (uint64_t) KERN_BASE - (uint64_t) addr)
+		return -1;
+
+	lock_acquire(&syscall_lock);
+	bool success = vm_madvise(addr, length, advice);
+	lock_release(&syscall_lock);
+	return success ? 0 : -1;
+}
+
+int msync (void *addr, size_t length){
+	if (addr == NULL || pg_ofs(addr) != 0 || !is_user_vaddr(addr)
+			|| length > (uint64_t) KERN_BASE - (uint64_t) addr)
+		return -1;
+
+	lock_acquire(&syscall_lock);
+	bool success = vm_msync(addr, length);
+	lock_release(&syscall_lock);
+	return success ? 0 : -1;
+}
+#endif
 
 void user_memory_valid(void *r){
 	struct thread *current = thread_current();  
-	uint64_t *pml4 = current->pml4;
-	if (r == NULL || is_kernel_vaddr(r) || pml4_get_page(pml4,r) == NULL){
+	if (r == NULL || is_kernel_vaddr(r)){
+		exit(-1);
+	}
+#ifdef VM
+	/* Pages are loaded lazily, so ask the SPT rather than the page table. */
+	if (spt_get_page(&current->spt, r) == NULL){
+		exit(-1);
+	}
+#else
+	if (pml4_get_page(current->pml4, r) == NULL){
 		exit(-1);
 	}
+#endif
 }
 
 struct file *get_file_by_descriptor(int fd)
@@ -1,7 +1,16 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
 #include "vm/vm.h"
+#include "vm/zswap.h"
 #include "devices/disk.h"
+#include <bitmap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -17,11 +26,220 @@ static const struct page_operations anon_ops = {
 	.type = VM_ANON,
 };
 
+/* Number of sectors in a swap slot.  A slot holds one page. */
+#define SLOT_SECTORS (PGSIZE / DISK_SECTOR_SIZE)
+
+/* Swap-in reads ahead the pages in up to SWAP_READAHEAD_SLOTS slots on
+ * each side of the faulting page's slot and up to SWAP_READAHEAD_PAGES
+ * pages on each side of its address, if they lie within SWAP_VA_WINDOW
+ * pages of it. */
+#define SWAP_READAHEAD_SLOTS 8
+#define SWAP_READAHEAD_PAGES 4
+#define SWAP_VA_WINDOW 32
+
+/* A swap slot in use. */
+struct swap_slot {
+	struct page *page;          /* Page stored in the slot, if known. */
+	unsigned ref_cnt;           /* Pages that have the slot as their copy. */
+};
+
+/* Swap devices.  Swap may span several of the ATA disks; the default is
+ * 1:1 alone.  The -swap kernel option lists them as CHAN:DEV or
+ * CHAN:DEV:PRIO, separated by commas, with priority 0 by default.  Each
+ * device holds a range of the swap slots: swap_devs is sorted by
+ * priority, highest first, and the devices' ranges follow each other in
+ * that order.  swap_disk is the first device.
+ *
+ * Slots are allocated on the highest-priority devices that have a free
+ * one.  Devices of equal priority take turns, preferring one on another
+ * channel than the last, so that the pages of an eviction pass are
+ * striped across the channels.  If swap spans both channels, each
+ * channel has a thread that performs the writes for its devices, so that
+ * the two channels transfer at once. */
+char *swap_devices;
+#define SWAP_DEV_MAX 4
+#define SWAP_CHANNELS 2
+
+struct swap_device {
+	struct disk *disk;
+	int chan_no, dev_no;
+	int prio;
+	size_t first;               /* First slot on the device. */
+	size_t slot_cnt;            /* Number of slots on the device. */
+	size_t used;                /* Number of those in use. */
+	size_t next;                /* Slot to look from for a free one. */
+	long long write_cnt;        /* # of pages written to the device;
+	                               protected by swap_lock. */
+};
+static struct swap_device swap_devs[SWAP_DEV_MAX];
+static size_t swap_dev_cnt;
+static size_t swap_rotor;           /* Next device to try. */
+static int swap_last_chan = -1;     /* Channel of the last slot allocated. */
+
+/* A page write queued for a channel's swap I/O thread. */
+struct swap_write {
+	struct list_elem elem;
+	size_t slot;
+	const void *kva;
+	struct semaphore *done;     /* Upped once the page is written. */
+};
+
+/* A channel's queue of writes, if swap spans both channels. */
+struct swap_channel {
+	struct list queue;
+	struct lock lock;           /* Protects queue. */
+	struct semaphore pending;   /* Number of writes in queue. */
+};
+static struct swap_channel swap_channels[SWAP_CHANNELS];
+static bool swap_io_threads;
+
+/* Most pages of one cluster whose writes are in flight at once. */
+#define SWAP_WRITE_BATCH 8
+
+/* Swap slot allocation.  A set bit in swap_slots marks a slot in use.
+ * slots records, for each, the page stored there, so that a swap-in can
+ * find the pages that were swapped out next to it, and how many pages
+ * share it after a fork.  All three are protected by swap_lock.
+ *
+ * A page read back from swap keeps its slot while swap is at most half
+ * full.  It is mapped read-only until it is first written, which frees
+ * the slot; until then the copy in swap is good, and evicting the page
+ * again needs no write. */
+static struct bitmap *swap_slots;
+static struct swap_slot *slots;
+static size_t slots_used;
+static struct lock swap_lock;
+
+/* Swap-in statistics. */
+static long long zswap_hit_cnt;     /* # of pages read from the pool. */
+static long long zswap_miss_cnt;    /* # of pages read from the disk. */
+static long long readahead_cnt;     /* # of pages read ahead from disk. */
+static long long clean_cnt;         /* # of evictions that kept a slot. */
+
+static void swap_readahead (struct page *page, size_t slot);
+static void slot_write (size_t slot, const void *kva);
+
+/* Adds disk CHAN_NO:DEV_NO, with priority PRIO, to the swap devices,
+ * keeping them sorted by priority.  Devices that do not exist or are
+ * already in use are skipped. */
+static void
+swap_device_add (int chan_no, int dev_no, int prio) {
+	struct disk *disk;
+	size_t i;
+
+	if (chan_no < 0 || chan_no >= SWAP_CHANNELS || dev_no < 0 || dev_no > 1
+			|| (disk = disk_get (chan_no, dev_no)) == NULL
+			|| swap_dev_cnt == SWAP_DEV_MAX) {
+		printf ("swap: no disk %d:%d, skipped\n", chan_no, dev_no);
+		return;
+	}
+	for (i = 0; i < swap_dev_cnt; i++)
+		if (swap_devs[i].disk == disk)
+			return;
+
+	for (i = swap_dev_cnt; i > 0 && swap_devs[i - 1].prio < prio; i--)
+		swap_devs[i] = swap_devs[i - 1];
+	memset (&swap_devs[i], 0, sizeof swap_devs[i]);
+	swap_devs[i].disk = disk;
+	swap_devs[i].chan_no = chan_no;
+	swap_devs[i].dev_no = dev_no;
+	swap_devs[i].prio = prio;
+	swap_devs[i].slot_cnt = disk_size (disk) / SLOT_SECTORS;
+	swap_dev_cnt++;
+}
+
+/* Sets up the swap devices listed in swap_devices, or the default. */
+static void
+swap_devices_init (void) {
+	char *dev, *save_ptr;
+	size_t first = 0, i;
+
+	if (swap_devices == NULL)
+		swap_device_add (1, 1, 0);
+	else
+		for (dev = strtok_r (swap_devices, ",", &save_ptr); dev != NULL;
+				dev = strtok_r (NULL, ",", &save_ptr)) {
+			char *chan, *dev_no, *prio, *save_ptr2;
+
+			chan = strtok_r (dev, ":", &save_ptr2);
+			dev_no = strtok_r (NULL, ":", &save_ptr2);
+			prio = strtok_r (NULL, ":", &save_ptr2);
+			if (dev_no == NULL)
+				PANIC ("bad swap device `%s' (use CHAN:DEV[:PRIO])", dev);
+			swap_device_add (atoi (chan), atoi (dev_no),
+					prio != NULL ? atoi (prio) : 0);
+		}
+
+	for (i = 0; i < swap_dev_cnt; i++) {
+		swap_devs[i].first = swap_devs[i].next = first;
+		first += swap_devs[i].slot_cnt;
+		if (swap_devs[i].chan_no != swap_devs[0].chan_no)
+			swap_io_threads = true;
+	}
+	swap_disk = swap_dev_cnt > 0 ? swap_devs[0].disk : NULL;
+}
+
+/* Swap I/O thread for the channel CHAN_, a swap_channel: performs the
+ * writes queued for it, in order. */
+static void
+swap_io_thread (void *chan_) {
+	struct swap_channel *chan = chan_;
+
+	for (;;) {
+		struct swap_write *w;
+
+		sema_down (&chan->pending);
+		lock_acquire (&chan->lock);
+		w = list_entry (list_pop_front (&chan->queue), struct swap_write, elem);
+		lock_release (&chan->lock);
+		slot_write (w->slot, w->kva);
+		sema_up (w->done);
+	}
+}
+
 /* Initialize the data for anonymous pages */
 void
 vm_anon_init (void) {
-	/* TODO: Set up the swap_disk. */
-	swap_disk = NULL;
+	size_t slot_cnt = 0, i;
+
+	swap_devices_init ();
+	for (i = 0; i < swap_dev_cnt; i++)
+		slot_cnt += swap_devs[i].slot_cnt;
+	swap_slots = bitmap_create (slot_cnt);
+	slots = calloc (slot_cnt + 1, sizeof *slots);
+	if (swap_slots == NULL || slots == NULL)
+		PANIC ("out of memory allocating the swap table");
+	lock_init (&swap_lock);
+	zswap_init ();
+
+	if (swap_io_threads)
+		for (i = 0; i < SWAP_CHANNELS; i++) {
+			struct swap_channel *chan = &swap_channels[i];
+			char name[16];
+
+			list_init (&chan->queue);
+			lock_init (&chan->lock);
+			sema_init (&chan->pending, 0);
+			snprintf (name, sizeof name, "swapio%zu", i);
+			thread_create (name, PRI_DEFAULT, swap_io_thread, chan);
+		}
+}
+
+/* Prints swap-in statistics. */
+void
+vm_anon_print_stats (void) {
+	size_t i;
+
+	printf ("Swap: %lld pages in from zswap, %lld from disk, "
+			"%lld read ahead, %lld evicted clean\n",
+			zswap_hit_cnt, zswap_miss_cnt, readahead_cnt, clean_cnt);
+	if (swap_dev_cnt > 1)
+		for (i = 0; i < swap_dev_cnt; i++)
+			printf ("Swap: hd%d:%d, priority %d: %zu slots, "
+					"%lld pages written\n", swap_devs[i].chan_no,
+					swap_devs[i].dev_no, swap_devs[i].prio, swap_devs[i].slot_cnt,
+					swap_devs[i].write_cnt);
+	zswap_print_stats ();
 }
 
 /* Initialize the file mapping */
@@ -31,22 +249,419 @@ anon_initializer (struct page *page, enum vm_type type, void *kva) {
 	page->operations = &anon_ops;
 
 	struct anon_page *anon_page = &page->anon;
+	anon_page->swap_slot = BITMAP_ERROR;
+	anon_page->zswap = NULL;
+	return true;
+}
+
+/* Returns the number of pages swap can hold, not counting the
+ * compressed pool. */
+size_t
+anon_swap_size (void) {
+	return swap_slots != NULL ? bitmap_size (swap_slots) : 0;
+}
+
+/* Adds DELTA to the number of pages with a copy in swap that PAGE's
+ * owner has. */
+static void
+swap_charge (struct page *page, int delta) {
+	lock_acquire (&swap_lock);
+	page->owner->swap_pages += delta;
+	lock_release (&swap_lock);
+}
+
+/* Returns the swap device that holds SLOT. */
+static struct swap_device *
+slot_device (size_t slot) {
+	size_t i;
+
+	for (i = 0; i + 1 < swap_dev_cnt; i++)
+		if (slot < swap_devs[i].first + swap_devs[i].slot_cnt)
+			break;
+	return &swap_devs[i];
+}
+
+/* Allocates a free swap slot, on the highest-priority device that has
+ * one.  Devices of that priority take turns, starting at swap_rotor,
+ * but one on another channel than the last slot's goes first.  Returns
+ * BITMAP_ERROR if swap is full.  The caller must hold swap_lock. */
+static size_t
+slot_alloc (void) {
+	struct swap_device *dev = NULL;
+	size_t lo, hi, i, pass, slot;
+
+	ASSERT (lock_held_by_current_thread (&swap_lock));
+
+	/* Find the devices of the highest priority with free slots. */
+	for (lo = 0; lo < swap_dev_cnt; lo++)
+		if (swap_devs[lo].used < swap_devs[lo].slot_cnt)
+			break;
+	if (lo == swap_dev_cnt)
+		return BITMAP_ERROR;
+	for (hi = lo + 1; hi < swap_dev_cnt; hi++)
+		if (swap_devs[hi].prio != swap_devs[lo].prio)
+			break;
+	if (swap_rotor < lo || swap_rotor >= hi)
+		swap_rotor = lo;
+
+	for (pass = 0; dev == NULL && pass < 2; pass++)
+		for (i = 0; i < hi - lo; i++) {
+			struct swap_device *d
+				= &swap_devs[lo + (swap_rotor - lo + i) % (hi - lo)];
+
+			if (d->used < d->slot_cnt
+					&& (pass == 1 || d->chan_no != swap_last_chan)) {
+				dev = d;
+				break;
+			}
+		}
+	swap_rotor = dev - swap_devs + 1;
+	swap_last_chan = dev->chan_no;
+	dev->used++;
+	slots_used++;
+
+	/* Take the next free slot after the last one taken on DEV, so that
+	 * the pages written to it one after another land next to each
+	 * other, or the first free slot on it. */
+	slot = bitmap_scan (swap_slots, dev->next, 1, false);
+	if (slot == BITMAP_ERROR || slot >= dev->first + dev->slot_cnt)
+		slot = bitmap_scan (swap_slots, dev->first, 1, false);
+	bitmap_mark (swap_slots, slot);
+	dev->next = slot + 1;
+	return slot;
+}
+
+/* Drops PAGE's reference to its swap slot, freeing the slot once no
+ * page refers to it. */
+static void
+slot_put (struct page *page) {
+	size_t slot = page->anon.swap_slot;
+
+	page->anon.swap_slot = BITMAP_ERROR;
+	lock_acquire (&swap_lock);
+	page->owner->swap_pages--;
+	ASSERT (bitmap_test (swap_slots, slot));
+	if (slots[slot].page == page)
+		slots[slot].page = NULL;
+	if (--slots[slot].ref_cnt == 0) {
+		bitmap_reset (swap_slots, slot);
+		slot_device (slot)->used--;
+		slots_used--;
+	}
+	lock_release (&swap_lock);
+}
+
+/* Called once PAGE has been read back from its slot.  Lets it keep the
+ * slot, unless swap is more than half full. */
+static void
+slot_release (struct page *page) {
+	if (slots_used > bitmap_size (swap_slots) / 2)
+		slot_put (page);
+}
+
+/* Frees the slot that PAGE, a resident anonymous page, kept when it was
+ * read back, because PAGE is about to be written. */
+void
+anon_drop_swap (struct page *page) {
+	ASSERT (page->anon.zswap == NULL);
+
+	if (page->anon.swap_slot != BITMAP_ERROR)
+		slot_put (page);
+}
+
+/* Reads SLOT into the page at KVA. */
+static void
+slot_read (size_t slot, void *kva) {
+	struct swap_device *dev = slot_device (slot);
+
+	disk_read_multiple (dev->disk, (slot - dev->first) * SLOT_SECTORS, kva,
+			SLOT_SECTORS);
+}
+
+/* Writes the page at KVA to SLOT, with a single disk command.  Both the
+ * evicting thread and the swap I/O threads write. */
+static void
+slot_write (size_t slot, const void *kva) {
+	struct swap_device *dev = slot_device (slot);
+
+	disk_write_multiple (dev->disk, (slot - dev->first) * SLOT_SECTORS, kva,
+			SLOT_SECTORS);
+	lock_acquire (&swap_lock);
+	dev->write_cnt++;
+	lock_release (&swap_lock);
 }
 
-/* Swap in the page by read contents from the swap disk. */
+/* Swap in the page by read contents from the compressed pool or the
+ * swap disk. */
 static bool
 anon_swap_in (struct page *page, void *kva) {
 	struct anon_page *anon_page = &page->anon;
+	size_t slot = anon_page->swap_slot;
+
+	if (anon_page->zswap != NULL) {
+		zswap_load (anon_page->zswap, kva);
+		zswap_put (anon_page->zswap);
+		anon_page->zswap = NULL;
+		swap_charge (page, -1);
+		zswap_hit_cnt++;
+		return true;
+	}
+	if (slot == BITMAP_ERROR) {
+		/* The OOM killer took the page's frame, and its contents are
+		 * gone.  Zeroes in their place could reach a file through a
+		 * write() the process is in the middle of, so the fault fails
+		 * instead, and the process exits as for a bad user pointer. */
+		return false;
+	}
+
+	zswap_miss_cnt++;
+	slot_read (slot, kva);
+	slot_release (page);
+	swap_readahead (page, slot);
+	return true;
+}
+
+/* Returns PAGE if it may be read ahead on behalf of a fault at VA: it
+ * belongs to OWNER, lies within SWAP_VA_WINDOW pages of VA and is an
+ * anonymous page swapped out to disk.  Otherwise returns NULL. */
+static struct page *
+readahead_candidate (struct page *page, struct thread *owner, void *va) {
+	uint64_t dist;
+
+	if (page == NULL || page->owner != owner
+			|| VM_TYPE (page->operations->type) != VM_ANON
+			|| page->frame != NULL || page->anon.zswap != NULL
+			|| page->anon.swap_slot == BITMAP_ERROR)
+		return NULL;
+	dist = page->va > va ? page->va - va : va - page->va;
+	return dist <= SWAP_VA_WINDOW * PGSIZE ? page : NULL;
+}
+
+/* Adds PAGE to the CNT pages in PAGES unless it is NULL or already
+ * there.  Returns the new count. */
+static size_t
+readahead_add (struct page **pages, size_t cnt, struct page *page) {
+	size_t i;
+
+	if (page == NULL)
+		return cnt;
+	for (i = 0; i < cnt; i++)
+		if (pages[i] == page)
+			return cnt;
+	pages[cnt] = page;
+	return cnt + 1;
+}
+
+/* Reads back the pages that PAGE's process is likely to need next, now
+ * that PAGE has been read from SLOT.  The pages of one eviction pass are
+ * swapped out into neighbouring slots, so the slots around SLOT hold
+ * pages that were last used together with PAGE; the pages next to PAGE
+ * in the address space are likely to be needed with it too.  Takes the
+ * swapped-out pages of the same process from both, reads them in slot
+ * order and installs them clean, into free frames only: readahead never
+ * evicts. */
+static void
+swap_readahead (struct page *page, size_t slot) {
+	struct page *pages[2 * (SWAP_READAHEAD_SLOTS + SWAP_READAHEAD_PAGES)];
+	struct thread *owner = page->owner;
+	size_t cnt = 0, lo, hi, i;
+
+	/* Only the owner swaps its own pages in, so the pages collected
+	 * below stay swapped out until the loop reaches them. */
+	if (owner != thread_current () || page->advice == VM_ADV_RANDOM)
+		return;
+
+	lo = slot > SWAP_READAHEAD_SLOTS ? slot - SWAP_READAHEAD_SLOTS : 0;
+	hi = slot + SWAP_READAHEAD_SLOTS + 1;
+	if (hi > bitmap_size (swap_slots))
+		hi = bitmap_size (swap_slots);
+
+	lock_acquire (&swap_lock);
+	for (i = lo; i < hi; i++)
+		cnt = readahead_add (pages, cnt,
+				readahead_candidate (slots[i].page, owner, page->va));
+	lock_release (&swap_lock);
+
+	for (i = 1; i <= SWAP_READAHEAD_PAGES; i++) {
+		struct supplemental_page_table *spt = &owner->spt;
+
+		cnt = readahead_add (pages, cnt, readahead_candidate (
+					spt_find_page (spt, page->va + i * PGSIZE), owner, page->va));
+		if ((uint64_t) page->va >= i * PGSIZE)
+			cnt = readahead_add (pages, cnt, readahead_candidate (
+						spt_find_page (spt, page->va - i * PGSIZE), owner,
+						page->va));
+	}
+
+	/* Sort by slot, so the disk sees the reads in order. */
+	for (i = 1; i < cnt; i++) {
+		struct page *p = pages[i];
+		size_t j;
+
+		for (j = i; j > 0
+				&& pages[j - 1]->anon.swap_slot > p->anon.swap_slot; j--)
+			pages[j] = pages[j - 1];
+		pages[j] = p;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		void *kva = vm_readahead_frame (pages[i]);
+
+		if (kva == NULL) {
+			if (pages[i]->frame != NULL)
+				continue;
+			break;
+		}
+		slot_read (pages[i]->anon.swap_slot, kva);
+		slot_release (pages[i]);
+		readahead_cnt++;
+		vm_readahead_done (pages[i], true);
+	}
 }
 
-/* Swap out the page by writing contents to the swap disk. */
+/* Swap out the page by writing contents to the compressed pool or the
+ * swap disk. */
 static bool
 anon_swap_out (struct page *page) {
-	struct anon_page *anon_page = &page->anon;
+	anon_swap_out_cluster (&page, 1);
+	return anon_in_swap (page);
+}
+
+/* Returns true if PAGE, an anonymous page, has a copy in swap.  A
+ * resident page may have one too, until it is written. */
+bool
+anon_in_swap (const struct page *page) {
+	return page->anon.zswap != NULL || page->anon.swap_slot != BITMAP_ERROR;
+}
+
+/* Swaps out the CNT anonymous PAGES, which must be resident and
+ * unmapped.  Pages that compress well go to the compressed pool while
+ * it has room.  The rest are striped across the swap devices by
+ * slot_alloc(), each page written with a single disk command, and the
+ * writes to the other channel than the first page's are left to that
+ * channel's I/O thread meanwhile.  The pages of one eviction pass that
+ * go to the same device land next to each other on it, which lets a
+ * later swap-in read them back together.
+ * Reorders PAGES.  Returns the number of pages swapped out, which is
+ * less than CNT only if swap is full; anon_in_swap() tells which. */
+size_t
+anon_swap_out_cluster (struct page **pages, size_t cnt) {
+	size_t stored = 0, done = 0, i;
+
+	/* Move the pages the pool does not take to the front. */
+	for (i = 0; i < cnt; i++) {
+		struct page *page = pages[i];
+
+		/* A page that kept its slot has not been written since it was
+		 * read back: the slot still holds it. */
+		if (page->anon.swap_slot != BITMAP_ERROR) {
+			stored++;
+			clean_cnt++;
+			continue;
+		}
+		page->anon.zswap = zswap_store (page->frame->kva);
+		if (page->anon.zswap != NULL) {
+			swap_charge (page, 1);
+			stored++;
+		} else
+			pages[i - stored] = page;
+	}
+	cnt -= stored;
+
+	while (done < cnt) {
+		struct swap_write writes[SWAP_WRITE_BATCH];
+		struct semaphore written;
+		size_t run, queued = 0, i;
+		int chan_no;
+
+		lock_acquire (&swap_lock);
+		for (run = 0; run < SWAP_WRITE_BATCH && done + run < cnt; run++) {
+			struct page *page = pages[done + run];
+			size_t slot = slot_alloc ();
+
+			if (slot == BITMAP_ERROR)
+				break;
+			slots[slot].page = page;
+			slots[slot].ref_cnt = 1;
+			page->anon.swap_slot = slot;
+			page->owner->swap_pages++;
+		}
+		lock_release (&swap_lock);
+		if (run == 0)
+			break;
+
+		sema_init (&written, 0);
+		chan_no = slot_device (pages[done]->anon.swap_slot)->chan_no;
+		for (i = 0; swap_io_threads && i < run; i++) {
+			struct page *page = pages[done + i];
+			struct swap_write *w = &writes[queued];
+			struct swap_channel *chan;
+			int chan_no2 = slot_device (page->anon.swap_slot)->chan_no;
+
+			if (chan_no2 == chan_no)
+				continue;
+			chan = &swap_channels[chan_no2];
+			w->slot = page->anon.swap_slot;
+			w->kva = page->frame->kva;
+			w->done = &written;
+			lock_acquire (&chan->lock);
+			list_push_back (&chan->queue, &w->elem);
+			lock_release (&chan->lock);
+			sema_up (&chan->pending);
+			queued++;
+		}
+		for (i = 0; i < run; i++) {
+			size_t slot = pages[done + i]->anon.swap_slot;
+
+			if (!swap_io_threads || slot_device (slot)->chan_no == chan_no)
+				slot_write (slot, pages[done + i]->frame->kva);
+		}
+		while (queued-- > 0)
+			sema_down (&written);
+		done += run;
+		if (run < SWAP_WRITE_BATCH && done < cnt)
+			break;
+	}
+	return stored + done;
+}
+
+/* Makes DST, a new anonymous page, share the swap copy of SRC, which must
+ * be swapped out.  Either page's first swap-in reads in a private copy. */
+void
+anon_share_swap (struct page *src, struct page *dst) {
+	size_t slot = src->anon.swap_slot;
+
+	ASSERT (anon_in_swap (src));
+
+	if (dst->anon.swap_slot == slot && slot != BITMAP_ERROR)
+		return;
+	if (dst->anon.swap_slot != BITMAP_ERROR)
+		slot_put (dst);
+	if (src->anon.zswap != NULL) {
+		zswap_get (src->anon.zswap);
+		dst->anon.zswap = src->anon.zswap;
+		swap_charge (dst, 1);
+		return;
+	}
+	lock_acquire (&swap_lock);
+	slots[slot].ref_cnt++;
+	dst->owner->swap_pages++;
+	lock_release (&swap_lock);
+	dst->anon.swap_slot = slot;
 }
 
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void
 anon_destroy (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+
+	/* Free the frame first: it waits for an eviction of PAGE that is
+	 * in progress, which would hand the page a slot. */
+	vm_free_frame (page, false);
+	if (anon_page->zswap != NULL) {
+		zswap_put (anon_page->zswap);
+		swap_charge (page, -1);
+	}
+	if (anon_page->swap_slot != BITMAP_ERROR)
+		slot_put (page);
 }
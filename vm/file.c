@@ -1,6 +1,11 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
 #include "vm/vm.h"
+#include <round.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/vaddr.h"
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
@@ -21,38 +26,222 @@ vm_file_init (void) {
 
 /* Initialize the file backed page */
 bool
-file_backed_initializer (struct page *page, enum vm_type type, void *kva) {
+file_backed_initializer (struct page *page, enum vm_type type,
+		void *kva UNUSED) {
 	/* Set up the handler */
 	page->operations = &file_ops;
 
 	struct file_page *file_page = &page->file;
+	file_page->file = NULL;
+	file_page->text = (type & VM_TEXT) != 0;
+	return true;
+}
+
+/* Moves INFO, the lazy_load_info of PAGE, into the page itself. */
+static void
+file_page_adopt (struct page *page, struct lazy_load_info *info) {
+	struct file_page *file_page = &page->file;
+
+	file_page->file = info->file;
+	file_page->ofs = info->ofs;
+	file_page->read_bytes = info->read_bytes;
+	free (info);
+}
+
+/* Loads a file-backed page on its first fault.  AUX is the page's
+ * lazy_load_info. */
+bool
+file_lazy_load (struct page *page, void *aux) {
+	file_page_adopt (page, aux);
+	return file_backed_swap_in (page, page->frame->kva);
+}
+
+/* Turns PAGE, an uninit page that file_lazy_load() would load, into a
+ * file-backed page without reading it, because its contents are already
+ * in a frame it is about to share. */
+bool
+file_backed_attach (struct page *page) {
+	struct uninit_page *uninit = &page->uninit;
+	struct lazy_load_info *info = uninit->aux;
+
+	ASSERT (VM_TYPE (page->operations->type) == VM_UNINIT);
+	ASSERT (uninit->init == file_lazy_load);
+
+	if (!uninit->page_initializer (page, uninit->type, NULL))
+		return false;
+	file_page_adopt (page, info);
+	return true;
 }
 
 /* Swap in the page by read contents from the file. */
 static bool
 file_backed_swap_in (struct page *page, void *kva) {
-	struct file_page *file_page UNUSED = &page->file;
+	struct file_page *file_page = &page->file;
+
+	if (file_read_at (file_page->file, kva, file_page->read_bytes,
+				file_page->ofs) != (off_t) file_page->read_bytes)
+		return false;
+	memset (kva + file_page->read_bytes, 0, PGSIZE - file_page->read_bytes);
+	return true;
 }
 
 /* Swap out the page by writeback contents to the file. */
 static bool
 file_backed_swap_out (struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
+	struct file_page *file_page = &page->file;
+	uint64_t *pml4 = page->owner->pml4;
+
+	/* Only a page that was written needs to go back to the file;
+	 * any other can be read from it again. */
+	if (pml4_is_dirty (pml4, page->va)) {
+		if (file_write_at (file_page->file, page->frame->kva,
+					file_page->read_bytes, file_page->ofs)
+				!= (off_t) file_page->read_bytes)
+			return false;
+		pml4_set_dirty (pml4, page->va, false);
+	}
+	return true;
+}
+
+/* Writes PAGE, a resident file-backed page, back to its file if it was
+ * modified, leaving it mapped.  The dirty bit is cleared before the
+ * write, so that a store racing with it marks the page dirty again
+ * instead of being lost.  Returns true if the page was written. */
+bool
+file_backed_writeback (struct page *page) {
+	struct file_page *file_page = &page->file;
+	uint64_t *pml4 = page->owner->pml4;
+
+	ASSERT (VM_TYPE (page->operations->type) == VM_FILE);
+
+	if (file_page->text || !pml4_is_dirty (pml4, page->va))
+		return false;
+	pml4_set_dirty (pml4, page->va, false);
+	if (file_write_at (file_page->file, page->frame->kva,
+				file_page->read_bytes, file_page->ofs)
+			!= (off_t) file_page->read_bytes) {
+		pml4_set_dirty (pml4, page->va, true);
+		return false;
+	}
+	return true;
 }
 
 /* Destory the file backed page. PAGE will be freed by the caller. */
 static void
 file_backed_destroy (struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
+	struct file_page *file_page = &page->file;
+
+	vm_free_frame (page, true);
+	file_close (file_page->file);
 }
 
-/* Do the mmap */
+/* Creates the page at VA, in VMA, a file mapping of the current process
+ * that has not touched it yet.  The page is loaded on its first fault. */
+bool
+file_map_page (struct vma *vma, void *va) {
+	size_t page_ofs = va - vma->start;
+	struct lazy_load_info *info;
+
+	ASSERT (vma->file != NULL);
+	ASSERT (pg_ofs (va) == 0 && va >= vma->start && va < vma->end);
+
+	info = malloc (sizeof *info);
+	if (info == NULL)
+		return false;
+	info->file = file_reopen (vma->file);
+	info->ofs = vma->ofs + page_ofs;
+	info->read_bytes = vma->file_bytes > page_ofs
+		? vma->file_bytes - page_ofs : 0;
+	if (info->read_bytes > PGSIZE)
+		info->read_bytes = PGSIZE;
+	if (info->file == NULL
+			|| !vm_alloc_page_with_initializer (VM_FILE, va, vma->writable,
+				file_lazy_load, info)) {
+		file_close (info->file);
+		free (info);
+		return false;
+	}
+	return true;
+}
+
+/* Do the mmap.  Only records the mapping: its pages are created by
+ * their first faults, so mapping a large region costs no more than
+ * mapping a small one. */
 void *
 do_mmap (void *addr, size_t length, int writable,
 		struct file *file, off_t offset) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	off_t file_bytes = file_length (file) - offset;
+	struct vma *vma;
+
+	ASSERT (pg_ofs (addr) == 0);
+	ASSERT (offset % PGSIZE == 0);
+
+	if (file_bytes <= 0)
+		return NULL;
+	if ((size_t) file_bytes > length)
+		file_bytes = length;
+
+	vma = malloc (sizeof *vma);
+	if (vma == NULL)
+		return NULL;
+	vma->start = addr;
+	vma->end = addr + ROUND_UP (length, PGSIZE);
+	vma->file = file_reopen (file);
+	vma->ofs = offset;
+	vma->file_bytes = file_bytes;
+	vma->writable = writable;
+	vma->advice = VM_ADV_NORMAL;
+	vma->stack = false;
+	list_init (&vma->pages);
+	vma->page_cnt = 0;
+	if (vma->file == NULL || !vma_insert (&spt->vmas, vma)) {
+		file_close (vma->file);
+		free (vma);
+		return NULL;
+	}
+	if (writable)
+		vm_writeback_start ();
+	return addr;
 }
 
-/* Do the munmap */
+/* Do the munmap.  Removes the pages the mapping created, writing back
+ * the ones that were modified; it never touched the others. */
 void
 do_munmap (void *addr) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct vma *vma = vma_find (&spt->vmas, addr);
+
+	if (vma == NULL || vma->start != addr || vma->file == NULL)
+		return;
+	while (!list_empty (&vma->pages))
+		spt_remove_page (spt, list_entry (list_front (&vma->pages),
+					struct page, vma_elem));
+	vma_remove (&spt->vmas, vma);
+	file_close (vma->file);
+	free (vma);
+}
+
+/* Creates a page in the current process that maps the same part of the
+ * same file as SRC, a file-backed page of another process.  The new page
+ * is loaded from the file on its first fault. */
+bool
+file_backed_dup (struct page *src) {
+	struct file_page *file_page = &src->file;
+	struct lazy_load_info *info = malloc (sizeof *info);
+
+	if (info == NULL)
+		return false;
+	info->file = file_reopen (file_page->file);
+	info->ofs = file_page->ofs;
+	info->read_bytes = file_page->read_bytes;
+	if (info->file == NULL
+			|| !vm_alloc_page_with_initializer (
+				VM_FILE | (file_page->text ? VM_TEXT : 0), src->va,
+				src->writable, file_lazy_load, info)) {
+		file_close (info->file);
+		free (info);
+		return false;
+	}
+	return true;
 }
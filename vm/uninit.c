@@ -8,6 +8,9 @@
  * function.
  * */
 
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
 #include "vm/vm.h"
 #include "vm/uninit.h"
 
@@ -51,9 +54,14 @@ uninit_initialize (struct page *page, void *kva) {
 	vm_initializer *init = uninit->init;
 	void *aux = uninit->aux;
 
-	/* TODO: You may need to fix this function. */
-	return uninit->page_initializer (page, uninit->type, kva) &&
-		(init ? init (page, aux) : true);
+	if (!uninit->page_initializer (page, uninit->type, kva))
+		return false;
+	if (init == NULL) {
+		/* Pages without an initializer start out zero-filled. */
+		memset (kva, 0, PGSIZE);
+		return true;
+	}
+	return init (page, aux);
 }
 
 /* Free the resources hold by uninit_page. Although most of pages are transmuted
@@ -62,7 +70,13 @@ uninit_initialize (struct page *page, void *kva) {
  * PAGE will be freed by the caller. */
 static void
 uninit_destroy (struct page *page) {
-	struct uninit_page *uninit UNUSED = &page->uninit;
-	/* TODO: Fill this function.
-	 * TODO: If you don't have anything to do, just return. */
+	struct uninit_page *uninit = &page->uninit;
+	struct lazy_load_info *info = uninit->aux;
+
+	/* An AUX, when present, is always a lazy_load_info that the page
+	 * owns until its initializer runs. */
+	if (info != NULL) {
+		file_close (info->file);
+		free (info);
+	}
 }
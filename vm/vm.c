@@ -1,9 +1,130 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
 
+/* Global frame table: every user frame that holds a loaded page, in
+ * clock order.  A frame joins the table once its page is loaded and
+ * mapped, and leaves it when the page is evicted or destroyed. */
+static struct list frame_table;
+static size_t frame_cnt;            /* Number of frames in frame_table. */
+
+/* Clock hand: the next frame vm_get_victim() examines.  NULL means the
+ * beginning of frame_table.  Kept between calls so each eviction picks
+ * up where the last one stopped. */
+static struct list_elem *clock_hand;
+
+/* Protects frame_table, clock_hand, the links between frames and pages
+ * and the processes' resident page counts.  Held across eviction, so a
+ * process faulting on a page that is being evicted waits for the
+ * eviction to finish. */
+static struct lock frame_lock;
+
+/* Signalled, under frame_lock, when a pinned frame is unpinned. */
+static struct condition unpin_cond;
+
+/* The zero frame: a single page of zeros, mapped read-only at every
+ * zero-fill anonymous page that has been read but not yet written.  It
+ * is never on the frame table and never freed.  Pages that map it have
+ * it as their frame, but are not linked into a ring of sharers. */
+static struct frame zero_frame;
+
+/* Text cache: the frames that hold executable text, keyed by the inode
+ * sector of the executable and the offset of the page in it, so that
+ * processes running the same binary share one frame per text page.  A
+ * frame leaves the cache when it is evicted or its last page is
+ * destroyed.  Protected by frame_lock. */
+static struct hash text_cache;
+static uint64_t text_hash (const struct hash_elem *, void *);
+static bool text_less (const struct hash_elem *, const struct hash_elem *,
+		void *);
+
+/* Same-page merging: every vm_ksm_interval ticks, the scanner hashes a
+ * batch of anonymous frames, picking up where the last batch stopped.  A
+ * frame whose contents have not changed since the last pass is looked up
+ * by hash among the stable frames, which pages have been merged into and
+ * which are mapped read-only, and then among the unstable frames, the
+ * other unchanged frames seen this pass.  If a frame's contents really
+ * match, its pages are merged into the frame found, copy-on-write, and
+ * the frame is freed.  The unstable table starts over with each pass.
+ * Both tables are protected by frame_lock. */
+int64_t vm_ksm_interval;
+static struct hash ksm_stable;
+static struct hash ksm_unstable;
+static struct list_elem *ksm_cursor;    /* Next frame to scan, or NULL. */
+static uint64_t ksm_hash (const struct hash_elem *, void *);
+static bool ksm_less (const struct hash_elem *, const struct hash_elem *,
+		void *);
+static void ksm_forget (struct frame *);
+static void vm_ksm_start (void);
+static void vm_ksm_print_stats (void);
+
+/* Most frames the scanner examines while holding frame_lock. */
+#define KSM_BATCH 32
+
+/* Number of pages past a faulting file-backed page that a read fault also
+ * loads, as long as they continue the same mapping.  0, the default,
+ * turns fault-around off.  Set with the -fault-around kernel option. */
+size_t vm_fault_around;
+
+/* Timer ticks between passes of the writeback daemon, which writes dirty
+ * file-backed pages back to their files in the background, so that
+ * eviction mostly finds them clean.  0 turns the daemon off.  Set with
+ * the -writeback kernel option. */
+int64_t vm_writeback_interval = TIMER_FREQ;
+
+/* Next frame the writeback daemon examines, or NULL for the beginning of
+ * frame_table.  Kept between passes, like clock_hand, so that a pass cut
+ * short by WRITEBACK_MAX is finished by the next one. */
+static struct list_elem *writeback_cursor;
+
+/* Most frames the writeback daemon examines while holding frame_lock,
+ * most pages it then writes back in one batch, and in one pass. */
+#define WRITEBACK_SCAN 64
+#define WRITEBACK_BATCH 16
+#define WRITEBACK_MAX 256
+
+/* Back each fully zero-fill, writable, huge-page aligned block of
+ * HUGE_PAGES anonymous pages with a single huge frame on its first
+ * fault, mapped by one PDE.  A huge frame is a single entry on the frame
+ * table; anything that has to deal with one of its pages on its own,
+ * such as eviction, fork or freeing the page, first splits it into
+ * ordinary frames.  Off by default; set with the -huge-pages kernel
+ * option. */
+bool vm_huge_pages;
+
+/* Most pages the stack grows by at once.  The first growth adds one
+ * page, and each after that twice as many as the last. */
+#define STACK_BATCH_MAX 32
+
+/* Pages that a fault on a page with sequential advice loads ahead, at
+ * least, and the distance behind the fault past which pages are made
+ * the next eviction candidates. */
+#define SEQ_WINDOW 16
+
+/* Statistics. */
+static long long fault_cnt;         /* # of faults resolved. */
+static long long fault_around_cnt;  /* # of pages loaded by fault-around. */
+static long long writeback_cnt;     /* # of pages written back early. */
+static long long hard_limit_cnt;    /* # of evictions to keep a hard limit. */
+static long long huge_cnt;          /* # of huge pages mapped. */
+static long long huge_split_cnt;    /* # of huge pages split. */
+static long long oom_kill_cnt;      /* # of processes the OOM killer chose. */
+static long long ksm_pass_cnt;      /* # of passes of the merging scanner. */
+static long long ksm_merge_cnt;     /* # of pages merged. */
+static long long stack_growth_cnt;  /* # of faults that grew a stack. */
+static long long stack_page_cnt;    /* # of stack pages created by those. */
+static long long stack_limit_cnt;   /* # of faults past a stack limit. */
+
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 void
@@ -15,7 +136,35 @@ vm_init (void) {
 #endif
 	register_inspect_intr ();
 	/* DO NOT MODIFY UPPER LINES. */
-	/* TODO: Your code goes here. */
+	list_init (&frame_table);
+	lock_init (&frame_lock);
+	cond_init (&unpin_cond);
+	clock_hand = NULL;
+	zero_frame.kva = palloc_get_page (PAL_ZERO | PAL_ASSERT);
+	hash_init (&text_cache, text_hash, text_less, NULL);
+	hash_init (&ksm_stable, ksm_hash, ksm_less, NULL);
+	hash_init (&ksm_unstable, ksm_hash, ksm_less, NULL);
+	vm_ksm_start ();
+}
+
+/* Prints virtual memory statistics. */
+void
+vm_print_stats (void) {
+	printf ("VM: %lld page faults resolved, %lld pages faulted around, "
+			"%lld pages written back, %lld evictions at an RSS limit\n",
+			fault_cnt, fault_around_cnt, writeback_cnt, hard_limit_cnt);
+	if (oom_kill_cnt > 0)
+		printf ("VM: %lld processes killed out of memory\n", oom_kill_cnt);
+	if (vm_huge_pages)
+		printf ("VM: %lld huge pages mapped, %lld split\n",
+				huge_cnt, huge_split_cnt);
+	if (stack_growth_cnt > 0 || stack_limit_cnt > 0)
+		printf ("VM: %lld stack growth faults created %lld pages, "
+				"%lld faults past the stack limit\n",
+				stack_growth_cnt, stack_page_cnt, stack_limit_cnt);
+	if (vm_ksm_interval > 0)
+		vm_ksm_print_stats ();
+	vm_anon_print_stats ();
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -33,9 +182,10 @@ page_get_type (struct page *page) {
 }
 
 /* Helpers */
-static struct frame *vm_get_victim (void);
+static struct frame *vm_get_victim (struct thread *owner);
 static bool vm_do_claim_page (struct page *page);
-static struct frame *vm_evict_frame (void);
+static struct frame *vm_evict_frame (struct thread *owner);
+static bool vm_stack_growth (void *addr);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -47,14 +197,46 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 	ASSERT (VM_TYPE(type) != VM_UNINIT)
 
 	struct supplemental_page_table *spt = &thread_current ()->spt;
+	bool (*initializer) (struct page *, enum vm_type, void *);
+
+	ASSERT (pg_ofs (upage) == 0);
 
 	/* Check wheter the upage is already occupied or not. */
 	if (spt_find_page (spt, upage) == NULL) {
-		/* TODO: Create the page, fetch the initialier according to the VM type,
-		 * TODO: and then create "uninit" page struct by calling uninit_new. You
-		 * TODO: should modify the field after calling the uninit_new. */
+		switch (VM_TYPE (type)) {
+			case VM_ANON:
+				initializer = anon_initializer;
+				break;
+			case VM_FILE:
+				initializer = file_backed_initializer;
+				break;
+			default:
+				goto err;
+		}
 
-		/* TODO: Insert the page into the spt. */
+		struct page *page = malloc (sizeof *page);
+		if (page == NULL)
+			goto err;
+		uninit_new (page, upage, init, type, aux, initializer);
+		page->owner = thread_current ();
+		page->writable = writable;
+		page->next_sharer = page;
+		page->advice = VM_ADV_NORMAL;
+
+		if (!spt_insert_page (spt, page)) {
+			free (page);
+			goto err;
+		}
+
+		/* A file mapping keeps track of the pages it has created. */
+		page->vma = vma_find (&spt->vmas, upage);
+		if (page->vma != NULL && page->vma->file != NULL) {
+			list_push_back (&page->vma->pages, &page->vma_elem);
+			page->vma->page_cnt++;
+			page->advice = page->vma->advice;
+		} else
+			page->vma = NULL;
+		return true;
 	}
 err:
 	return false;
@@ -62,82 +244,1668 @@ err:
 
 /* Find VA from spt and return page. On error, return NULL. */
 struct page *
-spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
-	struct page *page = NULL;
-	/* TODO: Fill this function. */
+spt_find_page (struct supplemental_page_table *spt, void *va) {
+	struct page key;
+	struct hash_elem *e;
 
-	return page;
+	key.va = pg_round_down (va);
+	e = hash_find (&spt->pages, &key.spt_elem);
+	return e != NULL ? hash_entry (e, struct page, spt_elem) : NULL;
+}
+
+/* Like spt_find_page(), but if VA lies in a file mapping of SPT, the
+ * current process's table, that has not touched it yet, creates the
+ * page there, and if VA is where the stack may grow to, grows it.
+ * Returns NULL if VA is not mapped or memory runs out. */
+struct page *
+spt_get_page (struct supplemental_page_table *spt, void *va) {
+	struct page *page = spt_find_page (spt, va);
+	struct vma *vma;
+
+	ASSERT (spt == &thread_current ()->spt);
+
+	if (page != NULL)
+		return page;
+	vma = vma_find (&spt->vmas, va);
+	if (vma == NULL || vma->stack) {
+		if (!vm_stack_growth (va))
+			return NULL;
+	} else if (vma->file == NULL
+			|| !file_map_page (vma, pg_round_down (va)))
+		return NULL;
+	return spt_find_page (spt, va);
 }
 
 /* Insert PAGE into spt with validation. */
 bool
-spt_insert_page (struct supplemental_page_table *spt UNUSED,
-		struct page *page UNUSED) {
-	int succ = false;
-	/* TODO: Fill this function. */
+spt_insert_page (struct supplemental_page_table *spt,
+		struct page *page) {
+	ASSERT (pg_ofs (page->va) == 0);
 
-	return succ;
+	return hash_insert (&spt->pages, &page->spt_elem) == NULL;
 }
 
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
+	hash_delete (&spt->pages, &page->spt_elem);
+	if (page->vma != NULL) {
+		list_remove (&page->vma_elem);
+		page->vma->page_cnt--;
+	}
 	vm_dealloc_page (page);
+}
+
+/* Adds FRAME to the frame table just behind the clock hand, so that it
+ * gets a full revolution before the hand first reaches it. */
+static void
+frame_table_insert (struct frame *frame) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (clock_hand == NULL)
+		list_push_back (&frame_table, &frame->elem);
+	else
+		list_insert (clock_hand, &frame->elem);
+	frame_cnt++;
+}
+
+/* Removes FRAME from the frame table, first moving the clock hand, the
+ * merging scanner and the writeback cursor off it if necessary.  A frame
+ * off the table is not merged into. */
+static void
+frame_table_remove (struct frame *frame) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (clock_hand == &frame->elem) {
+		clock_hand = list_next (clock_hand);
+		if (clock_hand == list_end (&frame_table))
+			clock_hand = NULL;
+	}
+	if (ksm_cursor == &frame->elem) {
+		ksm_cursor = list_next (ksm_cursor);
+		if (ksm_cursor == list_end (&frame_table))
+			ksm_cursor = NULL;
+	}
+	if (writeback_cursor == &frame->elem) {
+		writeback_cursor = list_next (writeback_cursor);
+		if (writeback_cursor == list_end (&frame_table))
+			writeback_cursor = NULL;
+	}
+	list_remove (&frame->elem);
+	frame_cnt--;
+	ksm_forget (frame);
+}
+
+/* Pins FRAME, so that its page can be written back without frame_lock:
+ * takes it off the frame table, which keeps it from being evicted, and
+ * makes vm_free_frame() wait until frame_unpin(). */
+static void
+frame_pin (struct frame *frame) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+	ASSERT (!frame->pinned);
+
+	frame_table_remove (frame);
+	frame->pinned = true;
+}
+
+/* Undoes frame_pin (FRAME). */
+static void
+frame_unpin (struct frame *frame) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+	ASSERT (frame->pinned);
+
+	frame->pinned = false;
+	frame_table_insert (frame);
+	cond_broadcast (&unpin_cond, &frame_lock);
+}
+
+/* Returns true if pages other than the one mapping FRAME may read it, so
+ * that it must be copied before that page is written. */
+static bool
+frame_is_shared (const struct frame *frame) {
+	return frame == &zero_frame || frame->ref_cnt > 1;
+}
+
+/* Returns true if PAGE has never been loaded and starts out zero-filled. */
+static bool
+page_is_zero_fill (struct page *page) {
+	return VM_TYPE (page->operations->type) == VM_UNINIT
+		&& VM_TYPE (page->uninit.type) == VM_ANON
+		&& page->uninit.init == NULL;
+}
+
+/* If PAGE is loaded from a file, by lazy_load_segment() or as part of a
+ * file mapping, returns that file and stores PAGE's offset in it in *OFS.
+ * Otherwise returns NULL. */
+static struct file *
+page_backing_file (struct page *page, off_t *ofs) {
+	switch (VM_TYPE (page->operations->type)) {
+		case VM_UNINIT:
+			/* Pages with an initializer all come from a file. */
+			if (page->uninit.init != NULL) {
+				struct lazy_load_info *info = page->uninit.aux;
+				*ofs = info->ofs;
+				return info->file;
+			}
+			return NULL;
+		case VM_FILE:
+			*ofs = page->file.ofs;
+			return page->file.file;
+		default:
+			return NULL;
+	}
+}
+
+/* Maps the zero frame read-only at PAGE, an anonymous page that is not
+ * resident and has no contents yet. */
+static bool
+zero_frame_map (struct page *page) {
+	ASSERT (page->frame == NULL);
+
+	page->frame = &zero_frame;
+	if (!pml4_set_page (page->owner->pml4, page->va, zero_frame.kva, false)) {
+		page->frame = NULL;
+		return false;
+	}
+	return true;
+}
+
+/* Returns a hash value for the frame that E belongs to. */
+static uint64_t
+text_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct frame *frame = hash_entry (e, struct frame, text_elem);
+	return hash_bytes (&frame->text_key, sizeof frame->text_key);
+}
+
+/* Returns true if frame A precedes frame B. */
+static bool
+text_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct frame, text_elem)->text_key
+		< hash_entry (b, struct frame, text_elem)->text_key;
+}
+
+/* If PAGE is executable text, stores its text cache key in *KEY and
+ * returns true. */
+static bool
+page_text_key (struct page *page, uint64_t *key) {
+	struct file *file;
+	off_t ofs;
+
+	switch (VM_TYPE (page->operations->type)) {
+		case VM_UNINIT:
+			if ((page->uninit.type & VM_TEXT) == 0)
+				return false;
+			break;
+		case VM_FILE:
+			if (!page->file.text)
+				return false;
+			break;
+		default:
+			return false;
+	}
+	file = page_backing_file (page, &ofs);
+	*key = (uint64_t) inode_get_inumber (file_get_inode (file)) << 32
+		| (uint32_t) ofs;
 	return true;
 }
 
-/* Get the struct frame, that will be evicted. */
+/* Adds FRAME, just loaded for PAGE, to the text cache if PAGE is text
+ * that is not cached yet. */
+static void
+text_cache_insert (struct frame *frame, struct page *page) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (page_text_key (page, &frame->text_key)
+			&& hash_insert (&text_cache, &frame->text_elem) == NULL)
+		frame->cached = true;
+}
+
+/* Removes FRAME from the text cache, if it is there. */
+static void
+text_cache_remove (struct frame *frame) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (frame->cached) {
+		hash_delete (&text_cache, &frame->text_elem);
+		frame->cached = false;
+	}
+}
+
+static void frame_share (struct frame *, struct page *);
+static void frame_unshare (struct frame *, struct page *);
+
+/* Looks up PAGE, which is not resident, in the text cache.  If its text
+ * is cached, makes PAGE share the frame, mapped read-only, and returns
+ * true. */
+static bool
+text_cache_attach (struct page *page) {
+	struct frame key, *frame;
+	struct hash_elem *e;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (!page_text_key (page, &key.text_key)
+			|| (e = hash_find (&text_cache, &key.text_elem)) == NULL)
+		return false;
+	frame = hash_entry (e, struct frame, text_elem);
+
+	if (VM_TYPE (page->operations->type) == VM_UNINIT
+			&& !file_backed_attach (page))
+		return false;
+	frame_share (frame, page);
+	if (!pml4_set_page (page->owner->pml4, page->va, frame->kva, false)) {
+		frame_unshare (frame, page);
+		return false;
+	}
+	return true;
+}
+
+/* Makes PAGE the only page that uses FRAME. */
+static void
+frame_link (struct frame *frame, struct page *page) {
+	frame->page = page;
+	frame->ref_cnt = 1;
+	page->frame = frame;
+	page->next_sharer = page;
+	page->owner->rss++;
+}
+
+/* Adds PAGE to the pages that share FRAME. */
+static void
+frame_share (struct frame *frame, struct page *page) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	page->next_sharer = frame->page->next_sharer;
+	frame->page->next_sharer = page;
+	page->frame = frame;
+	frame->ref_cnt++;
+	page->owner->rss++;
+}
+
+/* Removes PAGE from the pages that share FRAME.  At least one other page
+ * must remain. */
+static void
+frame_unshare (struct frame *frame, struct page *page) {
+	struct page *prev = page;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+	ASSERT (frame->ref_cnt > 1);
+
+	while (prev->next_sharer != page)
+		prev = prev->next_sharer;
+	prev->next_sharer = page->next_sharer;
+	if (frame->page == page)
+		frame->page = page->next_sharer;
+	frame->ref_cnt--;
+	page->frame = NULL;
+	page->next_sharer = page;
+	page->owner->rss--;
+}
+
+/* Detaches every page from FRAME, which is left unused. */
+static void
+frame_unlink_all (struct frame *frame) {
+	struct page *page = frame->page;
+	unsigned i;
+
+	for (i = 0; i < frame->ref_cnt; i++) {
+		struct page *next = page->next_sharer;
+		page->frame = NULL;
+		page->next_sharer = page;
+		page->owner->rss--;
+		page = next;
+	}
+	frame->page = NULL;
+	frame->ref_cnt = 0;
+	text_cache_remove (frame);
+}
+
+/* Splits FRAME, a huge frame, into HUGE_PAGES ordinary frames, one per
+ * page, mapped through a new page table and placed on the frame table
+ * where FRAME was.  FRAME itself becomes the frame of the first page.
+ * Returns false, leaving FRAME whole, if memory runs out. */
+static bool
+frame_split (struct frame *frame) {
+	struct page **pages = frame->huge;
+	struct list frames;
+	struct list_elem *next;
+	size_t i;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+	ASSERT (pages != NULL);
+
+	list_init (&frames);
+	for (i = 1; i < HUGE_PAGES; i++) {
+		struct frame *f = malloc (sizeof *f);
+		if (f == NULL)
+			goto fail;
+		list_push_back (&frames, &f->elem);
+	}
+	if (!pml4_split_huge_page (pages[0]->owner->pml4, pages[0]->va))
+		goto fail;
+
+	next = list_next (&frame->elem);
+	for (i = 1; i < HUGE_PAGES; i++) {
+		struct frame *f = list_entry (list_pop_front (&frames),
+				struct frame, elem);
+
+		f->kva = frame->kva + i * PGSIZE;
+		f->page = pages[i];
+		f->ref_cnt = 1;
+		f->huge = NULL;
+		f->pinned = false;
+		f->cached = false;
+		f->ksm = KSM_NONE;
+		f->ksm_checksum = 0;
+		pages[i]->frame = f;
+		list_insert (next, &f->elem);
+	}
+	frame_cnt += HUGE_PAGES - 1;
+	frame->huge = NULL;
+	free (pages);
+	huge_split_cnt++;
+	return true;
+
+fail:
+	while (!list_empty (&frames))
+		free (list_entry (list_pop_front (&frames), struct frame, elem));
+	return false;
+}
+
+/* Frees FRAME, a huge frame, whole, and unmaps it.  Its pages are left
+ * without a frame.  Only for when every one of them is being destroyed,
+ * which saves splitting FRAME a page at a time. */
+static void
+frame_free_huge (struct frame *frame) {
+	struct page **pages = frame->huge;
+	struct thread *owner = pages[0]->owner;
+	size_t i;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	frame_table_remove (frame);
+	pml4_clear_huge_page (owner->pml4, pages[0]->va);
+	for (i = 0; i < HUGE_PAGES; i++)
+		pages[i]->frame = NULL;
+	owner->rss -= HUGE_PAGES;
+	palloc_free_multiple (frame->kva, HUGE_PAGES);
+	free (pages);
+	free (frame);
+}
+
+/* If PAGE is part of a huge frame, splits the frame, so that PAGE can be
+ * dropped on its own.  Returns false, changing nothing, if memory runs
+ * out. */
+static bool
+vm_split_frame (struct page *page) {
+	bool success = true;
+
+	lock_acquire (&frame_lock);
+	if (page->frame != NULL && page->frame->huge != NULL)
+		success = frame_split (page->frame);
+	lock_release (&frame_lock);
+	return success;
+}
+
+/* Returns true if PAGE may be mapped writable when it alone uses its
+ * frame.  An anonymous page that kept its swap slot is mapped read-only,
+ * so that its first write faults and drops the slot, which would no
+ * longer match. */
+static bool
+page_map_writable (struct page *page) {
+	return page->writable
+		&& !(VM_TYPE (page->operations->type) == VM_ANON && anon_in_swap (page));
+}
+
+/* Maps FRAME at each of its pages' addresses.  Only a page that does not
+ * share the frame may be mapped writable. */
+static bool
+frame_map (struct frame *frame) {
+	struct page *page = frame->page;
+	unsigned i;
+
+	for (i = 0; i < frame->ref_cnt; i++, page = page->next_sharer)
+		if (!pml4_set_page (page->owner->pml4, page->va, frame->kva,
+					frame->ref_cnt == 1 && page_map_writable (page)))
+			return false;
+	return true;
+}
+
+/* Returns true if any page that shares FRAME has been accessed since the
+ * last call, clearing their accessed bits. */
+static bool
+frame_test_and_clear_accessed (struct frame *frame) {
+	struct page *page = frame->page;
+	bool accessed = false;
+	unsigned i;
+
+	for (i = 0; i < frame->ref_cnt; i++, page = page->next_sharer) {
+		uint64_t *pml4 = page->owner->pml4;
+		if (pml4_is_accessed (pml4, page->va)) {
+			pml4_set_accessed (pml4, page->va, false);
+			accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* Returns true if T has at least as many resident pages as its hard
+ * limit allows. */
+static bool
+rss_at_hard_limit (const struct thread *t) {
+	return t->rss_hard_limit != 0 && t->rss >= t->rss_hard_limit;
+}
+
+/* Returns true if FRAME belongs to a process over its soft limit. */
+static bool
+frame_over_soft_limit (const struct frame *frame) {
+	const struct thread *t = frame->page->owner;
+	return t->rss_soft_limit != 0 && t->rss > t->rss_soft_limit;
+}
+
+/* Get the struct frame, that will be evicted.
+ * Second-chance CLOCK: a frame whose page was accessed since the hand
+ * last passed it has its accessed bit cleared and is skipped.  After
+ * at most two revolutions every accessed bit has been cleared.  Frames
+ * of a process over its soft limit get no second chance, so that such a
+ * process gives up its pages before others do.
+ * If OWNER is non-null, only OWNER's frames are considered.  NULL is
+ * returned if two revolutions find no victim, which can also happen
+ * when the huge frames found cannot be split for lack of memory. */
 static struct frame *
-vm_get_victim (void) {
-	struct frame *victim = NULL;
-	 /* TODO: The policy for eviction is up to you. */
+vm_get_victim (struct thread *owner) {
+	size_t steps = 0;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (list_empty (&frame_table))
+		return NULL;
+
+	for (;;) {
+		if (clock_hand == NULL)
+			clock_hand = list_begin (&frame_table);
+
+		struct frame *frame = list_entry (clock_hand, struct frame, elem);
+
+		clock_hand = list_next (clock_hand);
+		if (clock_hand == list_end (&frame_table))
+			clock_hand = NULL;
+
+		if (++steps > 2 * frame_cnt)
+			return NULL;
+		if (owner != NULL && frame->page->owner != owner)
+			continue;
+		if (frame_over_soft_limit (frame)
+				|| !frame_test_and_clear_accessed (frame)) {
+			/* A huge page is evicted a base page at a time, starting
+			 * with its first; the hand moves on to the rest. */
+			if (frame->huge != NULL) {
+				if (!frame_split (frame))
+					continue;
+				clock_hand = list_next (&frame->elem);
+			}
+			return frame;
+		}
+	}
+}
+
+/* Most frames reclaimed by one eviction pass.  The anonymous victims of
+ * a pass are swapped out together, into contiguous swap slots. */
+#define EVICT_BATCH 8
+
+/* Puts FRAME, which was taken off the frame table for eviction but could
+ * not be swapped out, back in service. */
+static void
+vm_restore_frame (struct frame *frame) {
+	struct page *page = frame->page;
+	uint64_t *pml4 = page->owner->pml4;
+	bool dirty = pml4_is_dirty (pml4, page->va);
+
+	frame_map (frame);
+	pml4_set_dirty (pml4, page->va, dirty);
+	frame_table_insert (frame);
+}
 
-	return victim;
+/* Unmaps FRAME from every page that shares it. */
+static void
+frame_unmap (struct frame *frame) {
+	struct page *page = frame->page;
+	unsigned i;
+
+	for (i = 0; i < frame->ref_cnt; i++, page = page->next_sharer)
+		pml4_clear_page (page->owner->pml4, page->va);
 }
 
-/* Evict one page and return the corresponding frame.
+/* Evict a batch of up to EVICT_BATCH pages and return one of the freed
+ * frames; the others go back to the user pool.  If OWNER is non-null,
+ * only OWNER's pages are evicted.
  * Return NULL on error.*/
 static struct frame *
-vm_evict_frame (void) {
-	struct frame *victim UNUSED = vm_get_victim ();
-	/* TODO: swap out the victim and return the evicted frame. */
+vm_evict_frame (struct thread *owner) {
+	struct frame *victims[EVICT_BATCH];
+	struct page *anon[EVICT_BATCH];
+	struct frame *frame = NULL;
+	size_t victim_cnt, anon_cnt = 0, i;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	/* Take the victims off the frame table and unmap them first, so that
+	 * their owners fault (and wait on frame_lock) rather than write to
+	 * them while they are being swapped out. */
+	for (victim_cnt = 0; victim_cnt < EVICT_BATCH; victim_cnt++) {
+		struct frame *victim = vm_get_victim (owner);
+		if (victim == NULL)
+			break;
+		frame_table_remove (victim);
+		frame_unmap (victim);
+		victims[victim_cnt] = victim;
+		if (VM_TYPE (victim->page->operations->type) == VM_ANON)
+			anon[anon_cnt++] = victim->page;
+	}
+	if (anon_cnt > 0)
+		anon_swap_out_cluster (anon, anon_cnt);
+
+	for (i = 0; i < victim_cnt; i++) {
+		struct frame *victim = victims[i];
+		struct page *page = victim->page, *sharer;
+		bool evicted;
+
+		if (VM_TYPE (page->operations->type) == VM_ANON) {
+			evicted = anon_in_swap (page);
+			/* Pages that shared the frame now share its swap copy. */
+			for (sharer = page->next_sharer; evicted && sharer != page;
+					sharer = sharer->next_sharer)
+				anon_share_swap (page, sharer);
+		} else {
+			/* Shared text is never dirty, so this writes back at most
+			 * one page. */
+			evicted = true;
+			sharer = page;
+			do
+				evicted = evicted && swap_out (sharer);
+			while ((sharer = sharer->next_sharer) != page);
+		}
+		if (!evicted) {
+			vm_restore_frame (victim);
+			continue;
+		}
+		frame_unlink_all (victim);
+		if (frame == NULL)
+			frame = victim;
+		else {
+			palloc_free_page (victim->kva);
+			free (victim);
+		}
+	}
+	return frame;
+}
+
+/* Returns true if PAGE is a resident file-backed page that has been
+ * modified since it was last written back. */
+static bool
+page_needs_writeback (struct page *page) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	return page->frame != NULL
+		&& VM_TYPE (page->operations->type) == VM_FILE
+		&& pml4_is_dirty (page->owner->pml4, page->va);
+}
+
+/* Writes back the CNT file-backed PAGES, whose frames the caller pinned
+ * with frame_pin(), and then unpins them.  The writes are made without
+ * frame_lock, so that faults and evictions are not held up behind the
+ * disk.  The owners may still store to the pages meanwhile, which
+ * file_backed_writeback() copes with.  Returns the number of pages
+ * written; the others stay dirty. */
+static size_t
+vm_writeback_pinned (struct page **pages, size_t cnt) {
+	size_t written = 0, i;
+
+	ASSERT (!lock_held_by_current_thread (&frame_lock));
+
+	for (i = 0; i < cnt; i++)
+		if (file_backed_writeback (pages[i]))
+			written++;
+
+	lock_acquire (&frame_lock);
+	for (i = 0; i < cnt; i++)
+		frame_unpin (pages[i]->frame);
+	writeback_cnt += written;
+	lock_release (&frame_lock);
+	return written;
+}
+
+/* Examines up to WRITEBACK_SCAN frames, and no more than *LEFT, from
+ * writeback_cursor on, and writes back up to WRITEBACK_BATCH of the
+ * dirty file-backed pages among them.  Subtracts the frames examined
+ * from *LEFT.  Returns the number of pages written. */
+static size_t
+vm_writeback_batch (size_t *left) {
+	struct page *pages[WRITEBACK_BATCH];
+	size_t cnt = 0, scanned = 0;
+
+	lock_acquire (&frame_lock);
+	if (list_empty (&frame_table))
+		*left = 0;
+	while (*left > 0 && scanned < WRITEBACK_SCAN && cnt < WRITEBACK_BATCH) {
+		if (writeback_cursor == NULL)
+			writeback_cursor = list_begin (&frame_table);
+
+		struct frame *frame = list_entry (writeback_cursor, struct frame,
+				elem);
+
+		writeback_cursor = list_next (writeback_cursor);
+		if (writeback_cursor == list_end (&frame_table))
+			writeback_cursor = NULL;
+		scanned++;
+		(*left)--;
+
+		if (page_needs_writeback (frame->page)) {
+			frame_pin (frame);
+			pages[cnt++] = frame->page;
+			if (list_empty (&frame_table))
+				*left = 0;
+		}
+	}
+	lock_release (&frame_lock);
+	return vm_writeback_pinned (pages, cnt);
+}
+
+/* Writeback daemon: every vm_writeback_interval ticks, goes once around
+ * the frame table from where it last stopped and writes back the dirty
+ * file-backed pages, in batches so that faulting threads get frame_lock
+ * in between.  A pass stops after WRITEBACK_MAX pages, so that a process
+ * that keeps rewriting its pages cannot keep it busy. */
+static void
+vm_writeback_daemon (void *aux UNUSED) {
+	for (;;) {
+		size_t total = 0, left;
+
+		timer_sleep (vm_writeback_interval);
+		lock_acquire (&frame_lock);
+		left = frame_cnt;
+		lock_release (&frame_lock);
+		while (left > 0 && total < WRITEBACK_MAX)
+			total += vm_writeback_batch (&left);
+	}
+}
+
+/* Starts the writeback daemon, unless it is running or turned off.
+ * do_mmap() calls this for the first writable file mapping, so that
+ * kernels that never map a file run without it. */
+void
+vm_writeback_start (void) {
+	static bool started;
+
+	if (started || vm_writeback_interval <= 0)
+		return;
+	started = true;
+	thread_create ("writeback", PRI_DEFAULT, vm_writeback_daemon, NULL);
+}
+
+/* Returns a hash value for the frame that E belongs to. */
+static uint64_t
+ksm_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_entry (e, struct frame, ksm_elem)->ksm_checksum;
+}
+
+/* Returns true if frame A precedes frame B. */
+static bool
+ksm_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct frame, ksm_elem)->ksm_checksum
+		< hash_entry (b, struct frame, ksm_elem)->ksm_checksum;
+}
+
+/* Returns the merging table that holds frames in STATE. */
+static struct hash *
+ksm_table (enum ksm_state state) {
+	return state == KSM_STABLE ? &ksm_stable : &ksm_unstable;
+}
+
+/* Adds FRAME to the merging table for STATE, unless another frame with
+ * the same checksum is there. */
+static void
+ksm_add (struct frame *frame, enum ksm_state state) {
+	ASSERT (frame->ksm == KSM_NONE);
+
+	if (hash_insert (ksm_table (state), &frame->ksm_elem) == NULL)
+		frame->ksm = state;
+}
+
+/* Removes FRAME from the merging table it is in, if any.  Called when
+ * the frame leaves the frame table or becomes writable. */
+static void
+ksm_forget (struct frame *frame) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (frame->ksm != KSM_NONE) {
+		hash_delete (ksm_table (frame->ksm), &frame->ksm_elem);
+		frame->ksm = KSM_NONE;
+	}
+}
+
+/* Returns the frame in the merging table for STATE whose checksum is
+ * FRAME's, or NULL. */
+static struct frame *
+ksm_lookup (struct frame *frame, enum ksm_state state) {
+	struct hash_elem *e = hash_find (ksm_table (state), &frame->ksm_elem);
+	return e != NULL ? hash_entry (e, struct frame, ksm_elem) : NULL;
+}
+
+/* Maps FRAME again at each of its pages' addresses, like frame_map(),
+ * but read-only if PROTECT.  The pages' accessed bits are kept. */
+static void
+frame_remap (struct frame *frame, bool protect) {
+	struct page *page = frame->page;
+	unsigned i;
+
+	for (i = 0; i < frame->ref_cnt; i++, page = page->next_sharer) {
+		uint64_t *pml4 = page->owner->pml4;
+		bool accessed = pml4_is_accessed (pml4, page->va);
+
+		pml4_clear_page (pml4, page->va);
+		pml4_set_page (pml4, page->va, frame->kva,
+				!protect && frame->ref_cnt == 1 && page_map_writable (page));
+		pml4_set_accessed (pml4, page->va, accessed);
+	}
+}
+
+/* Merges the pages of DROP into KEEP, if the two frames hold the same
+ * contents, and frees DROP.  Both are write-protected first, so that
+ * neither can change between the comparison and the merge.  Returns
+ * false, leaving both frames as they were, if the contents differ. */
+static bool
+ksm_merge (struct frame *keep, struct frame *drop) {
+	struct page *page = drop->page;
+	unsigned cnt = drop->ref_cnt, i;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+	ASSERT (keep != drop);
+
+	frame_remap (keep, true);
+	frame_remap (drop, true);
+	if (memcmp (keep->kva, drop->kva, PGSIZE)) {
+		/* Stable frames stay read-only. */
+		if (keep->ksm != KSM_STABLE)
+			frame_remap (keep, false);
+		frame_remap (drop, false);
+		return false;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		struct page *next = page->next_sharer;
+		uint64_t *pml4 = page->owner->pml4;
+		bool accessed = pml4_is_accessed (pml4, page->va);
+
+		page->next_sharer = keep->page->next_sharer;
+		keep->page->next_sharer = page;
+		page->frame = keep;
+		keep->ref_cnt++;
+		pml4_clear_page (pml4, page->va);
+		pml4_set_page (pml4, page->va, keep->kva, false);
+		pml4_set_accessed (pml4, page->va, accessed);
+		page = next;
+	}
+	frame_table_remove (drop);
+	palloc_free_page (drop->kva);
+	free (drop);
+	ksm_merge_cnt += cnt;
+	return true;
+}
+
+/* Scans FRAME for the merging scanner. */
+static void
+ksm_scan (struct frame *frame) {
+	struct frame *match;
+	uint64_t checksum;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (frame->ksm != KSM_NONE || frame->huge != NULL
+			|| VM_TYPE (frame->page->operations->type) != VM_ANON)
+		return;
+
+	/* Leave alone frames that are still being written. */
+	checksum = hash_bytes (frame->kva, PGSIZE);
+	if (checksum != frame->ksm_checksum) {
+		frame->ksm_checksum = checksum;
+		return;
+	}
+
+	match = ksm_lookup (frame, KSM_STABLE);
+	if (match != NULL) {
+		ksm_merge (match, frame);
+		return;
+	}
+	match = ksm_lookup (frame, KSM_UNSTABLE);
+	if (match == NULL) {
+		ksm_add (frame, KSM_UNSTABLE);
+		return;
+	}
+
+	/* MATCH is not write-protected and may have changed since it was
+	 * hashed; if it has, FRAME takes its place. */
+	ksm_forget (match);
+	if (ksm_merge (match, frame)) {
+		match->ksm_checksum = hash_bytes (match->kva, PGSIZE);
+		ksm_add (match, KSM_STABLE);
+	} else
+		ksm_add (frame, KSM_UNSTABLE);
+}
+
+/* Resets FRAME, which is in the unstable table being cleared. */
+static void
+ksm_unstable_destructor (struct hash_elem *e, void *aux UNUSED) {
+	hash_entry (e, struct frame, ksm_elem)->ksm = KSM_NONE;
+}
+
+/* Merging scanner: every vm_ksm_interval ticks, scans the next
+ * KSM_BATCH frames of the frame table.  It runs at the lowest priority,
+ * so that it uses only time that no process wants. */
+static void
+vm_ksm_daemon (void *aux UNUSED) {
+	for (;;) {
+		size_t i;
+
+		timer_sleep (vm_ksm_interval);
+		lock_acquire (&frame_lock);
+		for (i = 0; i < KSM_BATCH && !list_empty (&frame_table); i++) {
+			struct frame *frame;
+
+			if (ksm_cursor == NULL) {
+				/* A new pass. */
+				hash_clear (&ksm_unstable, ksm_unstable_destructor);
+				ksm_cursor = list_begin (&frame_table);
+				ksm_pass_cnt++;
+			}
+			frame = list_entry (ksm_cursor, struct frame, elem);
+			ksm_cursor = list_next (ksm_cursor);
+			if (ksm_cursor == list_end (&frame_table))
+				ksm_cursor = NULL;
+			ksm_scan (frame);
+		}
+		lock_release (&frame_lock);
+	}
+}
+
+/* Starts the merging scanner, unless it is turned off. */
+static void
+vm_ksm_start (void) {
+	if (vm_ksm_interval > 0)
+		thread_create ("ksm", PRI_MIN, vm_ksm_daemon, NULL);
+}
+
+/* Prints the merging scanner's statistics: the pages merged so far, and
+ * the frames that merged pages share now, with the memory that saves. */
+static void
+vm_ksm_print_stats (void) {
+	struct hash_iterator i;
+	size_t shared = 0, sharing = 0;
+
+	lock_acquire (&frame_lock);
+	hash_first (&i, &ksm_stable);
+	while (hash_next (&i)) {
+		shared++;
+		sharing += hash_entry (hash_cur (&i), struct frame, ksm_elem)->ref_cnt;
+	}
+	lock_release (&frame_lock);
+	printf ("VM: %lld pages merged in %lld passes, %zu frames shared by "
+			"%zu pages, %zu bytes saved\n", ksm_merge_cnt, ksm_pass_cnt,
+			shared, sharing, (sharing - shared) * PGSIZE);
+}
+
+/* Sets the soft and hard limits on the current process's resident pages,
+ * 0 meaning no limit, and returns the number of pages it has resident.
+ * A process over a new hard limit shrinks as it faults.  Returns
+ * RSS_ERROR, changing nothing, if the hard limit is below RSS_MIN_LIMIT
+ * or the soft limit exceeds it. */
+size_t
+vm_rss_limit (size_t soft, size_t hard) {
+	struct thread *curr = thread_current ();
+	size_t rss;
+
+	if (hard != 0 && (hard < RSS_MIN_LIMIT || soft > hard))
+		return RSS_ERROR;
+
+	lock_acquire (&frame_lock);
+	curr->rss_soft_limit = soft;
+	curr->rss_hard_limit = hard;
+	rss = curr->rss;
+	lock_release (&frame_lock);
+	return rss;
+}
+
+/* Sets the current process's oom_score_adj to ADJ, clamped to between
+ * OOM_SCORE_ADJ_MIN, which keeps the OOM killer away from it, and
+ * OOM_SCORE_ADJ_MAX, which makes it the first choice.  Returns the
+ * previous value. */
+int
+vm_oom_score_adj (int adj) {
+	struct thread *curr = thread_current ();
+	int old = curr->oom_score_adj;
+
+	if (adj < OOM_SCORE_ADJ_MIN)
+		adj = OOM_SCORE_ADJ_MIN;
+	if (adj > OOM_SCORE_ADJ_MAX)
+		adj = OOM_SCORE_ADJ_MAX;
+	curr->oom_score_adj = adj;
+	return old;
+}
+
+/* Sets the stack size limit for the current process's next exec to
+ * LIMIT bytes, rounded up to whole pages, and returns the previous one.
+ * LIMIT 0 just returns it.  The stack of the running program keeps its
+ * limit.  Returns STACK_LIMIT_ERROR, changing nothing, if LIMIT is over
+ * STACK_LIMIT_MAX. */
+size_t
+vm_stack_limit (size_t limit) {
+	struct thread *curr = thread_current ();
+	size_t old = curr->stack_limit != 0 ? curr->stack_limit
+		: STACK_LIMIT_DEFAULT;
+
+	if (limit > STACK_LIMIT_MAX)
+		return STACK_LIMIT_ERROR;
+	if (limit != 0)
+		curr->stack_limit = ROUND_UP (limit, PGSIZE);
+	return old;
+}
+
+/* Turns PAGE, a loaded anonymous page, back into a zero-fill page that
+ * has not been touched yet, in place: its destroy hook gives up its frame
+ * and swap copy, and the page keeps its place in the supplemental page
+ * table and its other bookkeeping.  Cannot fail. */
+static void
+page_reset_zero_fill (struct page *page) {
+	struct page saved;
+
+	destroy (page);
+	saved = *page;
+	uninit_new (page, saved.va, NULL, VM_ANON, NULL, anon_initializer);
+	page->spt_elem = saved.spt_elem;
+	page->owner = saved.owner;
+	page->writable = saved.writable;
+	page->next_sharer = page;
+	page->advice = saved.advice;
+	page->vma = saved.vma;
+	page->vma_elem = saved.vma_elem;
+}
+
+/* Drops the contents of PAGE, a page of the current process.  A loaded
+ * anonymous page becomes a zero-fill page again, giving up its frame and
+ * swap copy.  A file-backed page is written back if it was modified and
+ * reloaded from its file when next touched.  Returns false, leaving the
+ * page as it was, if it is part of a huge page that memory is too short
+ * to split. */
+static bool
+vm_dontneed (struct page *page) {
+	switch (VM_TYPE (page->operations->type)) {
+		case VM_ANON:
+			if (!vm_split_frame (page))
+				return false;
+			page_reset_zero_fill (page);
+			return true;
+		case VM_FILE:
+			vm_free_frame (page, true);
+			return true;
+		default:
+			/* Never loaded: nothing to drop. */
+			return true;
+	}
+}
+
+/* Applies ADVICE, one of enum vm_advice, to the pages of the current
+ * process in the LENGTH bytes at ADDR, which must be page-aligned.
+ * Addresses with no page are skipped.  WILLNEED reads pages in ahead of
+ * their faults, like fault-around, into free frames only, and stops when
+ * there are none.  A file mapping that the range covers entirely passes
+ * NORMAL, RANDOM or SEQUENTIAL on to the pages it creates later.
+ * Returns false if ADVICE is unknown or memory runs out. */
+bool
+vm_madvise (void *addr, size_t length, int advice) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct vma *vma;
+	size_t ofs;
+
+	ASSERT (pg_ofs (addr) == 0);
+
+	if (advice < VM_ADV_NORMAL || advice > VM_ADV_DONTNEED)
+		return false;
+
+	if (advice < VM_ADV_WILLNEED)
+		for (vma = vma_find_overlap (&spt->vmas, addr, addr + length);
+				vma != NULL && vma->end <= addr + length;
+				vma = vma_find_overlap (&spt->vmas, vma->end, addr + length))
+			if (vma->start >= addr)
+				vma->advice = advice;
+
+	for (ofs = 0; ofs < length; ofs += PGSIZE) {
+		struct page *page = advice == VM_ADV_WILLNEED
+			? spt_get_page (spt, addr + ofs) : spt_find_page (spt, addr + ofs);
+		void *kva;
+
+		if (page == NULL)
+			continue;
+		switch (advice) {
+			case VM_ADV_WILLNEED:
+				if (page->frame != NULL || page_is_zero_fill (page))
+					break;
+				kva = vm_readahead_frame (page);
+				if (kva == NULL) {
+					if (page->frame == NULL)
+						return true;
+					break;
+				}
+				vm_readahead_done (page, swap_in (page, kva));
+				break;
+			case VM_ADV_DONTNEED:
+				if (!vm_dontneed (page))
+					return false;
+				break;
+			default:
+				page->advice = advice;
+		}
+	}
+	return true;
+}
+
+/* Adds PAGE, a page of a file mapping of the current process or NULL,
+ * to the *CNT PAGES that vm_msync() writes back, if it needs writing
+ * back, and pins its frame.  Writes the pages back once WRITEBACK_BATCH
+ * of them are collected.  Returns false if a write fails. */
+static bool
+msync_collect (struct page *page, struct page **pages, size_t *cnt) {
+	size_t written;
+
+	if (page == NULL)
+		return true;
+
+	lock_acquire (&frame_lock);
+	/* The writeback daemon may be writing the page already, possibly
+	 * without the latest stores; wait for it and look again. */
+	while (page->frame != NULL && page->frame->pinned)
+		cond_wait (&unpin_cond, &frame_lock);
+	if (page_needs_writeback (page)) {
+		frame_pin (page->frame);
+		pages[(*cnt)++] = page;
+	}
+	lock_release (&frame_lock);
+
+	if (*cnt < WRITEBACK_BATCH)
+		return true;
+	written = vm_writeback_pinned (pages, *cnt);
+	*cnt = 0;
+	return written == WRITEBACK_BATCH;
+}
+
+/* Writes back the modified pages of the file mappings in the LENGTH
+ * bytes at ADDR, which must be page-aligned, and leaves them mapped.
+ * In each mapping, either the pages it has created or the addresses in
+ * the range are visited, whichever are fewer, and only the dirty
+ * resident pages are written, without holding frame_lock.  Returns
+ * false if part of the range is not mapped or a write fails. */
+bool
+vm_msync (void *addr, size_t length) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct page *pages[WRITEBACK_BATCH];
+	void *end = addr + ROUND_UP (length, PGSIZE);
+	void *next = addr;
+	bool success = true;
+	size_t cnt = 0;
+	struct vma *vma;
+
+	ASSERT (pg_ofs (addr) == 0);
+
+	for (vma = vma_find_overlap (&spt->vmas, addr, end); vma != NULL;
+			vma = vma_find_overlap (&spt->vmas, vma->end, end)) {
+		void *lo = vma->start > addr ? vma->start : addr;
+		void *hi = vma->end < end ? vma->end : end;
+		struct list_elem *e;
+		void *va;
+
+		if (vma->start > next)
+			break;
+		next = vma->end;
+		if (vma->file == NULL)
+			continue;
+
+		if ((size_t) (hi - lo) / PGSIZE < vma->page_cnt) {
+			for (va = lo; va < hi; va += PGSIZE)
+				if (!msync_collect (spt_find_page (spt, va), pages, &cnt))
+					success = false;
+			continue;
+		}
+		for (e = list_begin (&vma->pages); e != list_end (&vma->pages);
+				e = list_next (e)) {
+			struct page *page = list_entry (e, struct page, vma_elem);
+
+			if (page->va >= lo && page->va < hi
+					&& !msync_collect (page, pages, &cnt))
+				success = false;
+		}
+	}
+	if (cnt > 0 && vm_writeback_pinned (pages, cnt) != cnt)
+		success = false;
+	return success && next >= end;
+}
+
+/* Reserves the LENGTH bytes at ADDR, which must be page-aligned, in
+ * the current process's address space, for pages that the caller
+ * creates itself: a segment of the executable or the stack.  Returns
+ * false if the range overlaps one in use or memory runs out. */
+bool
+vm_reserve (void *addr, size_t length) {
+	struct vma *vma;
+
+	ASSERT (pg_ofs (addr) == 0);
+
+	vma = calloc (1, sizeof *vma);
+	if (vma == NULL)
+		return false;
+	vma->start = addr;
+	vma->end = addr + ROUND_UP (length, PGSIZE);
+	vma->writable = true;
+	list_init (&vma->pages);
+	if (!vma_insert (&thread_current ()->spt.vmas, vma)) {
+		free (vma);
+		return false;
+	}
+	return true;
+}
+
+/* Reserves the stack's area in the current process's address space:
+ * the LIMIT bytes below TOP, which must be page-aligned, or
+ * STACK_LIMIT_DEFAULT bytes if LIMIT is 0.  Creates the top page of the
+ * stack; the rest are created by vm_stack_growth() as the stack grows.
+ * Returns false if memory runs out. */
+bool
+vm_setup_stack (void *top, size_t limit) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct vma *vma;
+
+	ASSERT (pg_ofs (top) == 0);
+
+	if (limit == 0)
+		limit = STACK_LIMIT_DEFAULT;
+	if (!vm_reserve (top - limit, limit))
+		return false;
+	vma = vma_find (&spt->vmas, top - PGSIZE);
+	vma->stack = true;
+	if (!vm_alloc_page (VM_ANON, top - PGSIZE, true))
+		return false;
+	spt->stack_bottom = top - PGSIZE;
+	spt->stack_batch = 1;
+	return true;
+}
+
+/* Allocates a frame from the user pool, without evicting.  Returns NULL
+ * if the pool is empty. */
+static struct frame *
+vm_alloc_frame (void) {
+	struct frame *frame;
+	void *kva = palloc_get_page (PAL_USER);
 
-	return NULL;
+	if (kva == NULL)
+		return NULL;
+	frame = malloc (sizeof *frame);
+	if (frame == NULL) {
+		palloc_free_page (kva);
+		return NULL;
+	}
+	frame->kva = kva;
+	frame->page = NULL;
+	frame->ref_cnt = 0;
+	frame->huge = NULL;
+	frame->pinned = false;
+	frame->cached = false;
+	frame->ksm = KSM_NONE;
+	frame->ksm_checksum = 0;
+	return frame;
+}
+
+/* The OOM killer's choice so far: the thread with the highest badness
+ * among those visited. */
+struct oom_search {
+	struct thread *victim;
+	long long badness;
+	size_t total;               /* Pages of memory and swap. */
+};
+
+/* Considers T, with SEARCH, an oom_search, as the OOM killer's victim.
+ * Its badness is the number of pages it holds in memory and in swap,
+ * plus its oom_score_adj in thousandths of TOTAL.  Kernel threads,
+ * processes already chosen, ones that hold nothing and ones whose
+ * oom_score_adj is OOM_SCORE_ADJ_MIN are never chosen. */
+static void
+oom_consider (struct thread *t, void *search_) {
+	struct oom_search *search = search_;
+	long long badness;
+
+	if (t->pml4 == NULL || t->oom_killed
+			|| t->oom_score_adj == OOM_SCORE_ADJ_MIN
+			|| t->rss + t->swap_pages == 0)
+		return;
+	badness = t->rss + t->swap_pages
+		+ (long long) t->oom_score_adj * (long long) search->total / 1000;
+	if (badness < 1)
+		badness = 1;
+	if (badness > search->badness) {
+		search->victim = t;
+		search->badness = badness;
+	}
+}
+
+/* Out of memory and swap: picks the process with the highest badness
+ * and kills it.  It exits with status -1 the next time it faults or
+ * returns from a system call; meanwhile, its anonymous pages that no
+ * other process shares are dropped at once, so that their frames can be
+ * reused.  Its swap slots are freed when it exits.  The victim may be
+ * the current process.  Returns false if no process may be killed. */
+static bool
+vm_oom_kill (void) {
+	struct oom_search search = { NULL, 0, frame_cnt + anon_swap_size () };
+	struct list_elem *e, *next;
+	enum intr_level old_level;
+	struct thread *victim;
+
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	/* A process whose pages are on the frame table has not got far
+	 * enough through its exit to free them, which takes frame_lock, so
+	 * it stays around while we hold that. */
+	old_level = intr_disable ();
+	thread_foreach (oom_consider, &search);
+	intr_set_level (old_level);
+	victim = search.victim;
+	if (victim == NULL)
+		return false;
+	victim->oom_killed = true;
+	oom_kill_cnt++;
+
+	for (e = list_begin (&frame_table); e != list_end (&frame_table);
+			e = next) {
+		struct frame *frame = list_entry (e, struct frame, elem);
+		struct page *page = frame->page;
+
+		if (page->owner != victim || frame->ref_cnt != 1
+				|| VM_TYPE (page->operations->type) != VM_ANON
+				|| (frame->huge != NULL && !frame_split (frame))) {
+			next = list_next (e);
+			continue;
+		}
+		next = list_next (e);
+		frame_table_remove (frame);
+		pml4_clear_page (victim->pml4, page->va);
+		frame_unlink_all (frame);
+		palloc_free_page (frame->kva);
+		free (frame);
+	}
+	return true;
 }
 
 /* palloc() and get frame. If there is no available page, evict the page
  * and return it. This always return valid address. That is, if the user pool
  * memory is full, this function evicts the frame to get the available memory
- * space.*/
+ * space.
+ * CHARGE, if non-null, is the process that will have one more resident
+ * page for the frame.  If it is at its hard limit, one of its own pages
+ * is evicted to make room, when it has any that can be.
+ * If nothing can be evicted because swap is full too, the OOM killer
+ * makes room.
+ * The caller must hold frame_lock.  The returned frame is not on the frame
+ * table yet. */
 static struct frame *
-vm_get_frame (void) {
+vm_get_frame (struct thread *charge) {
 	struct frame *frame = NULL;
-	/* TODO: Fill this function. */
 
-	ASSERT (frame != NULL);
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+
+	if (charge != NULL && rss_at_hard_limit (charge)) {
+		frame = vm_evict_frame (charge);
+		if (frame != NULL)
+			hard_limit_cnt++;
+	}
+	if (frame == NULL)
+		frame = vm_alloc_frame ();
+	while (frame == NULL) {
+		size_t tries;
+
+		/* Give every frame on the table a chance to be evicted before
+		 * killing anyone. */
+		for (tries = 0; frame == NULL && tries <= frame_cnt / EVICT_BATCH;
+				tries++)
+			frame = vm_evict_frame (NULL);
+		if (frame != NULL)
+			break;
+		if (!vm_oom_kill ())
+			PANIC ("out of memory and no process to kill");
+		frame = vm_alloc_frame ();
+	}
+
 	ASSERT (frame->page == NULL);
 	return frame;
 }
 
-/* Growing the stack. */
-static void
-vm_stack_growth (void *addr UNUSED) {
+/* Growing the stack.
+ * ADDR, an address the current process touched, has no page.  If it
+ * lies below the bottom of the stack, but not more than 8 bytes below
+ * the user stack pointer, as a PUSH may touch, grows the stack down to
+ * it, together with a batch of pages below it.  The first growth adds
+ * one page to the batch, and each after that twice as many as the last,
+ * up to STACK_BATCH_MAX, but never past the end of the stack's area,
+ * which the stack limit sets.  The batch is faulted in ahead into free
+ * frames, so that a stack that keeps growing takes a fault per batch
+ * rather than per page.  Returns false if ADDR may not be stack or
+ * memory runs out. */
+static bool
+vm_stack_growth (void *addr) {
+	struct thread *curr = thread_current ();
+	struct supplemental_page_table *spt = &curr->spt;
+	void *upage = pg_round_down (addr), *bottom, *va;
+	struct vma *vma;
+	size_t batch;
+
+	if (spt->stack_bottom == NULL || addr >= spt->stack_bottom
+			|| (uint8_t *) addr < (uint8_t *) curr->user_rsp - 8)
+		return false;
+	vma = vma_find (&spt->vmas, spt->stack_bottom);
+	if (addr < vma->start) {
+		stack_limit_cnt++;
+		return false;
+	}
+
+	batch = spt->stack_batch;
+	if ((size_t) (upage - vma->start) / PGSIZE < batch)
+		batch = (upage - vma->start) / PGSIZE;
+	bottom = upage - batch * PGSIZE;
+	stack_growth_cnt++;
+	if (spt->stack_batch < STACK_BATCH_MAX)
+		spt->stack_batch *= 2;
+
+	for (va = spt->stack_bottom - PGSIZE; va >= bottom; va -= PGSIZE) {
+		if (!vm_alloc_page (VM_ANON, va, true))
+			return spt->stack_bottom <= upage;
+		spt->stack_bottom = va;
+		stack_page_cnt++;
+	}
+
+	/* Fault in the batch below ADDR's page, nearest first. */
+	for (va = upage - PGSIZE; va >= bottom; va -= PGSIZE) {
+		struct page *page = spt_find_page (spt, va);
+		void *kva = vm_readahead_frame (page);
+
+		if (kva == NULL)
+			break;
+		vm_readahead_done (page, swap_in (page, kva));
+	}
+	return true;
 }
 
-/* Handle the fault on write_protected page */
+/* Returns the page at VA in SPT if it may be part of a huge page: a
+ * writable zero-fill page that has never been touched. */
+static struct page *
+huge_candidate (struct supplemental_page_table *spt, void *va) {
+	struct page *page = spt_find_page (spt, va);
+
+	if (page == NULL || !page_is_zero_fill (page) || !page->writable)
+		return NULL;
+	return page;
+}
+
+/* Backs the huge-page aligned block of pages around PAGE, a zero-fill
+ * page just faulted on, with a single huge frame, if every page in the
+ * block is a huge_candidate().  Returns false, changing nothing, if it
+ * does not qualify or no aligned run of free frames is left; the fault
+ * is then handled a base page at a time. */
 static bool
-vm_handle_wp (struct page *page UNUSED) {
+vm_claim_huge (struct page *page) {
+	struct thread *owner = page->owner;
+	void *base = (void *) ((uint64_t) page->va & ~(HUGE_PGSIZE - 1));
+	size_t idx = pg_no (page->va) - pg_no (base), i;
+	struct page **pages;
+	struct frame *frame;
+	void *kva;
+
+	if (owner->rss_hard_limit != 0
+			&& owner->rss + HUGE_PAGES > owner->rss_hard_limit)
+		return false;
+	pages = malloc (HUGE_PAGES * sizeof *pages);
+	if (pages == NULL)
+		return false;
+
+	/* Look below the faulting page first: a process that touches its
+	 * memory in order has just faulted in the page below, which rules
+	 * the block out at once. */
+	for (i = idx; i-- > 0; )
+		if ((pages[i] = huge_candidate (&owner->spt, base + i * PGSIZE)) == NULL)
+			goto fail;
+	for (i = idx; i < HUGE_PAGES; i++)
+		if ((pages[i] = huge_candidate (&owner->spt, base + i * PGSIZE)) == NULL)
+			goto fail;
+
+	frame = malloc (sizeof *frame);
+	if (frame == NULL)
+		goto fail;
+	kva = palloc_get_multiple_aligned (PAL_USER | PAL_ZERO, HUGE_PAGES,
+			HUGE_PAGES);
+	if (kva == NULL) {
+		free (frame);
+		goto fail;
+	}
+
+	lock_acquire (&frame_lock);
+	if (!pml4_set_huge_page (owner->pml4, base, kva, true)) {
+		lock_release (&frame_lock);
+		palloc_free_multiple (kva, HUGE_PAGES);
+		free (frame);
+		goto fail;
+	}
+	frame->kva = kva;
+	frame->page = pages[0];
+	frame->ref_cnt = 1;
+	frame->huge = pages;
+	frame->pinned = false;
+	frame->cached = false;
+	frame->ksm = KSM_NONE;
+	frame->ksm_checksum = 0;
+	for (i = 0; i < HUGE_PAGES; i++) {
+		struct page *p = pages[i];
+
+		p->uninit.page_initializer (p, p->uninit.type, NULL);
+		p->frame = frame;
+		p->next_sharer = p;
+	}
+	owner->rss += HUGE_PAGES;
+	frame_table_insert (frame);
+	huge_cnt++;
+	lock_release (&frame_lock);
+	return true;
+
+fail:
+	free (pages);
+	return false;
+}
+
+/* Turns PAGE, a zero-fill page read before it was ever written, into an
+ * anonymous page that maps the zero frame.  Its first write gets it a
+ * frame of its own. */
+static bool
+vm_map_zero_page (struct page *page) {
+	bool success;
+
+	if (!page->uninit.page_initializer (page, page->uninit.type, NULL))
+		return false;
+
+	lock_acquire (&frame_lock);
+	success = zero_frame_map (page);
+	lock_release (&frame_lock);
+	return success;
+}
+
+/* Handle the fault on write_protected page.
+ * PAGE shares its frame copy-on-write, or maps the zero frame.  If other
+ * pages may still read the frame, give PAGE a private copy; if PAGE is
+ * the last user, just make it writable again.  Either way the faulting
+ * access is retried. */
+static bool
+vm_handle_wp (struct page *page) {
+	uint64_t *pml4 = page->owner->pml4;
+	struct frame *frame, *copy = NULL;
+
+	lock_acquire (&frame_lock);
+	if (page->frame != NULL && frame_is_shared (page->frame))
+		copy = vm_get_frame (page->frame == &zero_frame ? page->owner : NULL);
+
+	/* Getting the copy may have evicted the shared frame.  If so, the
+	 * retried access faults it back in, privately. */
+	frame = page->frame;
+	if (frame != NULL && frame_is_shared (frame)) {
+		memcpy (copy->kva, frame->kva, PGSIZE);
+		if (frame == &zero_frame)
+			page->frame = NULL;
+		else
+			frame_unshare (frame, page);
+		frame_link (copy, page);
+		frame_table_insert (copy);
+		frame = copy;
+		copy = NULL;
+	}
+	if (frame != NULL) {
+		/* The frame is about to change. */
+		ksm_forget (frame);
+		if (VM_TYPE (page->operations->type) == VM_ANON)
+			anon_drop_swap (page);
+		pml4_clear_page (pml4, page->va);
+		pml4_set_page (pml4, page->va, frame->kva, true);
+	}
+	lock_release (&frame_lock);
+
+	if (copy != NULL) {
+		palloc_free_page (copy->kva);
+		free (copy);
+	}
+	return true;
+}
+
+/* Fault-around: PAGE, which maps offset OFS of INODE, was just loaded by a
+ * fault.  Loads up to WINDOW of the pages that follow it, as long as they
+ * map the following pages of the same file, so that reading through a
+ * binary or a mapped file does not take a fault per page.  Only free
+ * frames are used. */
+static void
+vm_fault_around_from (struct page *page, struct inode *inode, off_t ofs,
+		size_t window) {
+	struct supplemental_page_table *spt = &page->owner->spt;
+	size_t i;
+
+	for (i = 1; i <= window; i++) {
+		struct page *next = spt_get_page (spt, page->va + i * PGSIZE);
+		struct file *file;
+		off_t next_ofs;
+		void *kva;
+
+		if (next == NULL || (file = page_backing_file (next, &next_ofs)) == NULL
+				|| file_get_inode (file) != inode
+				|| next_ofs != ofs + (off_t) (i * PGSIZE))
+			break;
+		if (next->frame != NULL)
+			continue;
+		kva = vm_readahead_frame (next);
+		if (kva == NULL) {
+			if (next->frame != NULL)
+				continue;
+			break;
+		}
+		vm_readahead_done (next, swap_in (next, kva));
+		fault_around_cnt++;
+	}
+}
+
+/* Returns how many pages past PAGE a fault on it loads with fault-around:
+ * none for a write or with random advice, more with sequential advice. */
+static size_t
+vm_fault_around_window (struct page *page, bool write) {
+	switch (page->advice) {
+		case VM_ADV_RANDOM:
+			return 0;
+		case VM_ADV_SEQUENTIAL:
+			return vm_fault_around > SEQ_WINDOW ? vm_fault_around : SEQ_WINDOW;
+		default:
+			return write ? 0 : vm_fault_around;
+	}
+}
+
+/* PAGE, which has sequential advice, was just faulted in.  The pages well
+ * behind it are done with, so clears their accessed bits: the clock then
+ * evicts them before pages that still have a second chance. */
+static void
+vm_drop_behind (struct page *page) {
+	struct supplemental_page_table *spt = &page->owner->spt;
+	size_t i;
+
+	lock_acquire (&frame_lock);
+	for (i = SEQ_WINDOW + 1; i <= 2 * SEQ_WINDOW; i++) {
+		struct page *behind;
+
+		if ((uint64_t) page->va < i * PGSIZE)
+			break;
+		behind = spt_find_page (spt, page->va - i * PGSIZE);
+		if (behind != NULL && behind->frame != NULL
+				&& behind->frame != &zero_frame)
+			pml4_set_accessed (page->owner->pml4, behind->va, false);
+	}
+	lock_release (&frame_lock);
 }
 
 /* Return true on success */
 bool
-vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
-		bool user UNUSED, bool write UNUSED, bool not_present UNUSED) {
-	struct supplemental_page_table *spt UNUSED = &thread_current ()->spt;
+vm_try_handle_fault (struct intr_frame *f, void *addr,
+		bool user UNUSED, bool write, bool not_present) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
 	struct page *page = NULL;
-	/* TODO: Validate the fault */
-	/* TODO: Your code goes here */
+	struct file *file;
+	size_t window;
+	off_t ofs;
 
-	return vm_do_claim_page (page);
+	if (addr == NULL || !is_user_vaddr (addr))
+		return false;
+	/* A process the OOM killer chose dies on its next fault from user
+	 * mode.  A fault from the kernel still loads the pages it has left,
+	 * but not those the killer took: anon_swap_in() fails for those. */
+	if (user && thread_current ()->oom_killed)
+		return false;
+	if (user)
+		thread_current ()->user_rsp = (void *) f->rsp;
+
+	page = spt_get_page (spt, addr);
+	if (page == NULL)
+		return false;
+	if (write && !page->writable)
+		return false;
+	if (!not_present)
+		return write && vm_handle_wp (page);
+	if (vm_huge_pages && page_is_zero_fill (page) && vm_claim_huge (page)) {
+		fault_cnt++;
+		return true;
+	}
+	if (!write && page_is_zero_fill (page))
+		return vm_map_zero_page (page);
+
+	/* Note where the page comes from before loading it consumes that. */
+	file = page_backing_file (page, &ofs);
+	if (!vm_do_claim_page (page))
+		return false;
+	fault_cnt++;
+	/* A page read back from swap comes in read-only; a write would only
+	 * fault again. */
+	if (write && !page_map_writable (page))
+		vm_handle_wp (page);
+	window = vm_fault_around_window (page, write);
+	if (file != NULL && window > 0)
+		vm_fault_around_from (page, file_get_inode (file), ofs, window);
+	if (page->advice == VM_ADV_SEQUENTIAL)
+		vm_drop_behind (page);
+	return true;
 }
 
 /* Free the page.
@@ -150,41 +1918,363 @@ vm_dealloc_page (struct page *page) {
 
 /* Claim the page that allocate on VA. */
 bool
-vm_claim_page (void *va UNUSED) {
-	struct page *page = NULL;
-	/* TODO: Fill this function */
+vm_claim_page (void *va) {
+	struct page *page = spt_find_page (&thread_current ()->spt, va);
 
+	if (page == NULL)
+		return false;
 	return vm_do_claim_page (page);
 }
 
+/* Finishes loading PAGE into the frame it was linked to while off the
+ * frame table: maps it and puts the frame on the table if LOADED,
+ * otherwise frees the frame.  Returns true if PAGE ends up mapped. */
+static bool
+vm_install_frame (struct page *page, bool loaded) {
+	struct frame *frame = page->frame;
+
+	if (!loaded || !pml4_set_page (page->owner->pml4, page->va, frame->kva,
+				page_map_writable (page))) {
+		lock_acquire (&frame_lock);
+		page->frame = NULL;
+		page->owner->rss--;
+		lock_release (&frame_lock);
+		palloc_free_page (frame->kva);
+		free (frame);
+		return false;
+	}
+
+	lock_acquire (&frame_lock);
+	frame_table_insert (frame);
+	text_cache_insert (frame, page);
+	lock_release (&frame_lock);
+	return true;
+}
+
 /* Claim the PAGE and set up the mmu. */
 static bool
 vm_do_claim_page (struct page *page) {
-	struct frame *frame = vm_get_frame ();
+	struct frame *frame;
+
+	lock_acquire (&frame_lock);
+	if (page->frame != NULL) {
+		/* Already resident. */
+		lock_release (&frame_lock);
+		return true;
+	}
+	if (text_cache_attach (page)) {
+		lock_release (&frame_lock);
+		return true;
+	}
+	frame = vm_get_frame (page->owner);
 
 	/* Set links */
-	frame->page = page;
-	page->frame = frame;
+	frame_link (frame, page);
+	lock_release (&frame_lock);
+
+	/* The frame is not on the frame table while it is being filled, so
+	 * it cannot be chosen for eviction half-loaded. */
+	return vm_install_frame (page, swap_in (page, frame->kva));
+}
+
+/* Starts reading PAGE in ahead of an access.  Gives PAGE a frame from the
+ * user pool, without evicting anything, and returns its kernel address.
+ * Returns NULL if PAGE is already resident, including when it just found
+ * its text in the text cache, or the pool is empty, or PAGE's owner is at
+ * its hard RSS limit.  The
+ * caller fills the frame and then calls vm_readahead_done(). */
+void *
+vm_readahead_frame (struct page *page) {
+	struct frame *frame = NULL;
+
+	lock_acquire (&frame_lock);
+	if (page->frame == NULL && !text_cache_attach (page)
+			&& !rss_at_hard_limit (page->owner)) {
+		frame = vm_alloc_frame ();
+		if (frame != NULL)
+			frame_link (frame, page);
+	}
+	lock_release (&frame_lock);
+	return frame != NULL ? frame->kva : NULL;
+}
 
-	/* TODO: Insert page table entry to map page's VA to frame's PA. */
+/* Finishes a readahead started by vm_readahead_frame().  LOADED tells
+ * whether the caller managed to fill the frame. */
+void
+vm_readahead_done (struct page *page, bool loaded) {
+	vm_install_frame (page, loaded);
+}
+
+/* Unmaps PAGE from its owner and frees the frame that holds it, if any,
+ * unless other pages still share the frame.  If SAVE, the contents are
+ * first saved with swap_out(), which for a file-backed page writes them
+ * back if they were modified.  Page types call this from their destroy
+ * hook.
+ * A huge frame is freed whole with the first of its pages, because this
+ * is only reached for one while the whole address space is torn down.
+ * Dropping one page of a huge frame on its own takes vm_split_frame()
+ * first. */
+void
+vm_free_frame (struct page *page, bool save) {
+	struct frame *frame;
+
+	lock_acquire (&frame_lock);
+	while (page->frame != NULL && page->frame->pinned)
+		cond_wait (&unpin_cond, &frame_lock);
+	if (page->frame != NULL && page->frame->huge != NULL) {
+		ASSERT (page->owner->spt.dying);
+		frame_free_huge (page->frame);
+	}
+	frame = page->frame;
+	if (frame != NULL) {
+		pml4_clear_page (page->owner->pml4, page->va);
+		if (frame == &zero_frame)
+			page->frame = NULL;
+		else if (frame->ref_cnt > 1)
+			frame_unshare (frame, page);
+		else {
+			frame_table_remove (frame);
+			text_cache_remove (frame);
+			if (save)
+				swap_out (page);
+			page->frame = NULL;
+			page->owner->rss--;
+			palloc_free_page (frame->kva);
+			free (frame);
+		}
+	}
+	lock_release (&frame_lock);
+}
 
-	return swap_in (page, frame->kva);
+/* Returns a hash value for the page that E belongs to. */
+static uint64_t
+page_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct page *page = hash_entry (e, struct page, spt_elem);
+	return hash_bytes (&page->va, sizeof page->va);
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	const struct page *page_a = hash_entry (a, struct page, spt_elem);
+	const struct page *page_b = hash_entry (b, struct page, spt_elem);
+	return page_a->va < page_b->va;
 }
 
 /* Initialize new supplemental page table */
 void
-supplemental_page_table_init (struct supplemental_page_table *spt UNUSED) {
+supplemental_page_table_init (struct supplemental_page_table *spt) {
+	hash_init (&spt->pages, page_hash, page_less, NULL);
+	vma_tree_init (&spt->vmas);
+	spt->stack_bottom = NULL;
+	spt->stack_batch = 1;
+	spt->dying = false;
+}
+
+/* Duplicates SRC_PAGE, a loaded file-backed page of the parent process,
+ * into the current process.  The child's page maps the same part of the
+ * file, but is not shared with the parent: it starts out with the
+ * parent's current contents, which may not have been written back. */
+static bool
+copy_file_page (struct page *src_page) {
+	struct page *dst_page;
+	struct frame *frame;
+	bool success, copied = false;
+
+	if (!file_backed_dup (src_page))
+		return false;
+	dst_page = spt_find_page (&thread_current ()->spt, src_page->va);
+
+	/* Text is never modified, and a fault finds the parent's frame in
+	 * the text cache. */
+	if (src_page->file.text)
+		return true;
+
+	/* If the parent's page is not resident, the file is up to date and
+	 * the child's page can be loaded from it later. */
+	lock_acquire (&frame_lock);
+	if (src_page->frame == NULL) {
+		lock_release (&frame_lock);
+		return true;
+	}
+	frame = vm_get_frame (dst_page->owner);
+	frame_link (frame, dst_page);
+	lock_release (&frame_lock);
+
+	success = swap_in (dst_page, frame->kva);
+	if (success) {
+		/* Getting the frame may have evicted the parent's page, which
+		 * wrote it back to the file we just read. */
+		lock_acquire (&frame_lock);
+		if (src_page->frame != NULL) {
+			memcpy (frame->kva, src_page->frame->kva, PGSIZE);
+			copied = true;
+		}
+		lock_release (&frame_lock);
+	}
+	if (!vm_install_frame (dst_page, success))
+		return false;
+	if (copied)
+		pml4_set_dirty (dst_page->owner->pml4, dst_page->va, true);
+	return true;
+}
+
+/* Duplicates SRC_PAGE, which belongs to the parent process, into the
+ * current process. */
+static bool
+copy_page (struct page *src_page) {
+	enum vm_type type = src_page->operations->type;
+	void *va = src_page->va;
+
+	if (VM_TYPE (type) == VM_UNINIT) {
+		struct lazy_load_info *info = src_page->uninit.aux;
+
+		if (info != NULL) {
+			struct lazy_load_info *copy = malloc (sizeof *copy);
+			if (copy == NULL)
+				return false;
+			*copy = *info;
+			copy->file = file_reopen (info->file);
+			if (copy->file == NULL
+					|| !vm_alloc_page_with_initializer (src_page->uninit.type, va,
+						src_page->writable, src_page->uninit.init, copy)) {
+				file_close (copy->file);
+				free (copy);
+				return false;
+			}
+			return true;
+		}
+		return vm_alloc_page_with_initializer (src_page->uninit.type, va,
+				src_page->writable, src_page->uninit.init, NULL);
+	}
+
+	if (VM_TYPE (type) == VM_FILE)
+		return copy_file_page (src_page);
+
+	/* The page is a loaded anonymous page.  The child shares the
+	 * parent's frame, or its swap slot, copy-on-write.  A page that maps
+	 * the zero frame still maps it in the child. */
+	struct page *dst_page;
+	bool success = true;
+
+	if (VM_TYPE (type) != VM_ANON
+			|| !vm_alloc_page (type, va, src_page->writable))
+		return false;
+	dst_page = spt_find_page (&thread_current ()->spt, va);
+
+	/* Turn the new page into an anonymous page without giving it a
+	 * frame of its own. */
+	if (!dst_page->uninit.page_initializer (dst_page, dst_page->uninit.type,
+				NULL))
+		return false;
+
+	lock_acquire (&frame_lock);
+	if (src_page->frame == &zero_frame)
+		success = zero_frame_map (dst_page);
+	else if (src_page->frame != NULL) {
+		struct frame *frame = src_page->frame;
+
+		/* Frames are shared copy-on-write a base page at a time. */
+		if (frame->huge != NULL) {
+			if (!frame_split (frame)) {
+				lock_release (&frame_lock);
+				return false;
+			}
+			frame = src_page->frame;
+		}
+		frame_share (frame, dst_page);
+		if (!frame_map (frame)) {
+			pml4_clear_page (dst_page->owner->pml4, va);
+			frame_unshare (frame, dst_page);
+			success = false;
+		}
+	} else if (anon_in_swap (src_page))
+		anon_share_swap (src_page, dst_page);
+	else {
+		/* The OOM killer took the frame. */
+		success = false;
+	}
+	lock_release (&frame_lock);
+	return success;
+}
+
+/* Adds a copy of SRC, an area of the parent process, to DST, the
+ * current process's table.  A file mapping gets no pages: the pages it
+ * created are copied after it, and the others are left untouched. */
+static bool
+copy_vma (struct vma *src, void *dst) {
+	struct vma *vma = malloc (sizeof *vma);
+
+	if (vma == NULL)
+		return false;
+	*vma = *src;
+	list_init (&vma->pages);
+	vma->page_cnt = 0;
+	if (src->file != NULL && (vma->file = file_reopen (src->file)) == NULL) {
+		free (vma);
+		return false;
+	}
+	if (!vma_insert (&((struct supplemental_page_table *) dst)->vmas, vma)) {
+		file_close (vma->file);
+		free (vma);
+		return false;
+	}
+	return true;
 }
 
 /* Copy supplemental page table from src to dst */
 bool
-supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
-		struct supplemental_page_table *src UNUSED) {
+supplemental_page_table_copy (struct supplemental_page_table *dst,
+		struct supplemental_page_table *src) {
+	struct hash_iterator i;
+
+	ASSERT (dst == &thread_current ()->spt);
+
+	/* Pages join their areas as they are created. */
+	if (!vma_tree_for_each (&src->vmas, copy_vma, dst))
+		return false;
+
+	hash_first (&i, &src->pages);
+	while (hash_next (&i)) {
+		struct page *src_page = hash_entry (hash_cur (&i), struct page,
+				spt_elem);
+		struct page *dst_page;
+
+		if (!copy_page (src_page))
+			return false;
+		dst_page = spt_find_page (dst, src_page->va);
+		if (dst_page != NULL)
+			dst_page->advice = src_page->advice;
+	}
+	dst->stack_bottom = src->stack_bottom;
+	dst->stack_batch = src->stack_batch;
+	return true;
+}
+
+/* Destroys the page that E belongs to. */
+static void
+page_destructor (struct hash_elem *e, void *aux UNUSED) {
+	vm_dealloc_page (hash_entry (e, struct page, spt_elem));
+}
+
+/* Frees VMA, whose pages have already been destroyed. */
+static void
+vma_destructor (struct vma *vma) {
+	file_close (vma->file);
+	free (vma);
 }
 
 /* Free the resource hold by the supplemental page table */
 void
-supplemental_page_table_kill (struct supplemental_page_table *spt UNUSED) {
-	/* TODO: Destroy all the supplemental_page_table hold by thread and
-	 * TODO: writeback all the modified contents to the storage. */
+supplemental_page_table_kill (struct supplemental_page_table *spt) {
+	/* Each page's destroy hook writes back modified contents and
+	 * releases its frame.  The table itself stays usable, because exec
+	 * kills the old address space and loads the new one into it. */
+	spt->dying = true;
+	hash_clear (&spt->pages, page_destructor);
+	spt->dying = false;
+	vma_tree_clear (&spt->vmas, vma_destructor);
+	spt->stack_bottom = NULL;
+	spt->stack_batch = 1;
 }
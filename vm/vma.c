@@ -0,0 +1,189 @@
+/* vma.c: Per-process tree of virtual memory areas.
+ *
+ * The areas never overlap, so ordering them by start address also
+ * orders them by end address, and a plain search tree answers interval
+ * queries: the first area that overlaps [START, END) is the leftmost one
+ * that ends after START, provided it begins before END.  The tree is an
+ * AVL tree, which keeps every operation O(log n). */
+
+#include "vm/vm.h"
+#include <debug.h>
+
+/* Initializes TREE as an empty tree. */
+void
+vma_tree_init (struct vma_tree *tree) {
+	tree->root = NULL;
+}
+
+static int
+height (const struct vma *vma) {
+	return vma != NULL ? vma->height : 0;
+}
+
+/* Recomputes the height of VMA from its children's. */
+static void
+update_height (struct vma *vma) {
+	int left = height (vma->left), right = height (vma->right);
+
+	vma->height = (left > right ? left : right) + 1;
+}
+
+static struct vma *
+rotate_right (struct vma *vma) {
+	struct vma *left = vma->left;
+
+	vma->left = left->right;
+	left->right = vma;
+	update_height (vma);
+	update_height (left);
+	return left;
+}
+
+static struct vma *
+rotate_left (struct vma *vma) {
+	struct vma *right = vma->right;
+
+	vma->right = right->left;
+	right->left = vma;
+	update_height (vma);
+	update_height (right);
+	return right;
+}
+
+/* Restores the balance of the subtree rooted at VMA, whose children
+ * are balanced and differ in height by at most 2.  Returns the new root
+ * of the subtree. */
+static struct vma *
+rebalance (struct vma *vma) {
+	int balance = height (vma->left) - height (vma->right);
+
+	if (balance > 1) {
+		if (height (vma->left->left) < height (vma->left->right))
+			vma->left = rotate_left (vma->left);
+		return rotate_right (vma);
+	}
+	if (balance < -1) {
+		if (height (vma->right->right) < height (vma->right->left))
+			vma->right = rotate_right (vma->right);
+		return rotate_left (vma);
+	}
+	update_height (vma);
+	return vma;
+}
+
+static struct vma *
+insert (struct vma *root, struct vma *vma) {
+	if (root == NULL)
+		return vma;
+	if (vma->start < root->start)
+		root->left = insert (root->left, vma);
+	else
+		root->right = insert (root->right, vma);
+	return rebalance (root);
+}
+
+/* Removes the leftmost area from the subtree at ROOT and stores it in
+ * *MIN.  Returns the new root of the subtree. */
+static struct vma *
+remove_min (struct vma *root, struct vma **min) {
+	if (root->left == NULL) {
+		*min = root;
+		return root->right;
+	}
+	root->left = remove_min (root->left, min);
+	return rebalance (root);
+}
+
+static struct vma *
+remove (struct vma *root, struct vma *vma) {
+	struct vma *min, *right;
+
+	ASSERT (root != NULL);
+
+	if (vma->start < root->start)
+		root->left = remove (root->left, vma);
+	else if (vma->start > root->start)
+		root->right = remove (root->right, vma);
+	else {
+		if (root->right == NULL)
+			return root->left;
+		right = remove_min (root->right, &min);
+		min->left = root->left;
+		min->right = right;
+		root = min;
+	}
+	return rebalance (root);
+}
+
+/* Adds VMA, whose START and END must be set, to TREE.  Returns false,
+ * without adding it, if it overlaps an area already in TREE. */
+bool
+vma_insert (struct vma_tree *tree, struct vma *vma) {
+	ASSERT (vma->start < vma->end);
+
+	if (vma_find_overlap (tree, vma->start, vma->end) != NULL)
+		return false;
+	vma->left = vma->right = NULL;
+	vma->height = 1;
+	tree->root = insert (tree->root, vma);
+	return true;
+}
+
+/* Removes VMA, which must be in TREE, from TREE. */
+void
+vma_remove (struct vma_tree *tree, struct vma *vma) {
+	tree->root = remove (tree->root, vma);
+}
+
+/* Returns the area of TREE that contains ADDR, or NULL if none does. */
+struct vma *
+vma_find (struct vma_tree *tree, void *addr) {
+	return vma_find_overlap (tree, addr, addr + 1);
+}
+
+/* Returns the lowest area of TREE that overlaps [START, END), or NULL
+ * if none does. */
+struct vma *
+vma_find_overlap (struct vma_tree *tree, void *start, void *end) {
+	struct vma *vma = tree->root, *found = NULL;
+
+	while (vma != NULL)
+		if (vma->end > start) {
+			found = vma;
+			vma = vma->left;
+		} else
+			vma = vma->right;
+	return found != NULL && found->start < end ? found : NULL;
+}
+
+static bool
+for_each (struct vma *vma, bool (*action) (struct vma *, void *), void *aux) {
+	return vma == NULL
+		|| (for_each (vma->left, action, aux) && action (vma, aux)
+				&& for_each (vma->right, action, aux));
+}
+
+/* Calls ACTION with AUX on each area of TREE in address order, until
+ * ACTION returns false.  ACTION must not change TREE.  Returns false if
+ * ACTION did. */
+bool
+vma_tree_for_each (struct vma_tree *tree,
+		bool (*action) (struct vma *, void *aux), void *aux) {
+	return for_each (tree->root, action, aux);
+}
+
+static void
+clear (struct vma *vma, void (*destructor) (struct vma *)) {
+	if (vma != NULL) {
+		clear (vma->left, destructor);
+		clear (vma->right, destructor);
+		destructor (vma);
+	}
+}
+
+/* Empties TREE, calling DESTRUCTOR on each of its areas. */
+void
+vma_tree_clear (struct vma_tree *tree, void (*destructor) (struct vma *)) {
+	clear (tree->root, destructor);
+	tree->root = NULL;
+}
@@ -0,0 +1,207 @@
+/* zswap.c: Compressed in-memory pool in front of the swap disk.
+ *
+ * An anonymous page that is swapped out is first compressed.  If it
+ * shrinks to at most half a page and the pool has room, the compressed
+ * copy stays in kernel memory and the page never touches the disk.
+ * Zero-filled, text-like and sparse pages typically compress to a small
+ * fraction of a page.
+ *
+ * The compressor is a small LZ77 variant in the style of LZJB: the
+ * output is a sequence of items, each a literal byte or a two-byte
+ * back-reference holding a 6-bit match length and a 10-bit offset, with
+ * a "copy map" byte ahead of every eight items telling which are which. */
+
+#include "vm/zswap.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+#define LZ_MATCH_BITS 6
+#define LZ_MATCH_MIN 3
+#define LZ_MATCH_MAX ((1 << LZ_MATCH_BITS) + (LZ_MATCH_MIN - 1))
+#define LZ_OFFSET_MASK ((1 << (16 - LZ_MATCH_BITS)) - 1)
+#define LZ_HASH_SIZE 1024
+
+/* A compressed page. */
+struct zswap_entry {
+	unsigned ref_cnt;           /* Pages that have this as their copy. */
+	size_t len;                 /* Length of DATA. */
+	uint8_t data[];             /* Compressed contents. */
+};
+
+/* Largest entry the pool accepts, header included.  Beyond this the page
+ * does not compress well enough to be worth keeping in memory. */
+#define ZSWAP_MAX_ENTRY (PGSIZE / 2)
+
+size_t zswap_pool_pages = 64;
+
+/* Pool state, protected by zswap_lock.  The compressor's hash table and
+ * output buffer are static because kernel stacks are small. */
+static struct lock zswap_lock;
+static size_t pool_bytes;           /* Bytes held by entries. */
+static uint16_t lz_table[LZ_HASH_SIZE];
+static uint8_t lz_buffer[ZSWAP_MAX_ENTRY - sizeof (struct zswap_entry)];
+
+/* Statistics. */
+static long long store_cnt;         /* # of pages stored. */
+static long long reject_cnt;        /* # of pages that did not compress. */
+static long long full_cnt;          /* # of pages turned away, pool full. */
+
+/* Compresses the SRC_LEN bytes at SRC into DST, which has room for
+ * DST_LEN bytes.  Returns the compressed length, or 0 if it would exceed
+ * DST_LEN. */
+static size_t
+lz_compress (const uint8_t *src, size_t src_len, uint8_t *dst,
+		size_t dst_len) {
+	const uint8_t *s = src, *end = src + src_len;
+	uint8_t *d = dst, *dst_end = dst + dst_len;
+	uint8_t *copymap = NULL;
+	unsigned copymask = 1 << 7;
+
+	ASSERT (src_len < UINT16_MAX);
+
+	/* Table entries are positions in SRC plus one; 0 means none. */
+	memset (lz_table, 0, sizeof lz_table);
+	while (s < end) {
+		size_t pos = s - src;
+
+		/* Worst case: a new copy map byte and a back-reference. */
+		if (d + 3 > dst_end)
+			return 0;
+		if ((copymask <<= 1) == (1 << 8)) {
+			copymask = 1;
+			copymap = d;
+			*d++ = 0;
+		}
+
+		if (s + LZ_MATCH_MAX <= end) {
+			unsigned hash = (s[0] << 16) + (s[1] << 8) + s[2];
+			uint16_t *slot;
+			size_t offset, len;
+
+			hash += hash >> 9;
+			hash += hash >> 5;
+			slot = &lz_table[hash & (LZ_HASH_SIZE - 1)];
+			offset = pos + 1 - *slot;
+			*slot = pos + 1;
+
+			if (offset <= pos && offset <= LZ_OFFSET_MASK) {
+				const uint8_t *cpy = s - offset;
+				for (len = 0; len < LZ_MATCH_MAX && s[len] == cpy[len]; len++)
+					continue;
+				if (len >= LZ_MATCH_MIN) {
+					*copymap |= copymask;
+					*d++ = ((len - LZ_MATCH_MIN) << (8 - LZ_MATCH_BITS))
+						| (offset >> 8);
+					*d++ = offset;
+					s += len;
+					continue;
+				}
+			}
+		}
+		*d++ = *s++;
+	}
+	return d - dst;
+}
+
+/* Decompresses the SRC_LEN bytes at SRC, produced by lz_compress(), into
+ * the DST_LEN bytes at DST. */
+static void
+lz_decompress (const uint8_t *src, size_t src_len, uint8_t *dst,
+		size_t dst_len) {
+	const uint8_t *s = src, *end = src + src_len;
+	uint8_t *d = dst, *dst_end = dst + dst_len;
+	uint8_t copymap = 0;
+	unsigned copymask = 1 << 7;
+
+	while (d < dst_end) {
+		ASSERT (s < end);
+		if ((copymask <<= 1) == (1 << 8)) {
+			copymask = 1;
+			copymap = *s++;
+		}
+		if (copymap & copymask) {
+			size_t len = (s[0] >> (8 - LZ_MATCH_BITS)) + LZ_MATCH_MIN;
+			size_t offset = ((s[0] << 8) | s[1]) & LZ_OFFSET_MASK;
+			const uint8_t *cpy = d - offset;
+
+			ASSERT (cpy >= dst && d + len <= dst_end);
+			s += 2;
+			/* Byte by byte: the source may overlap what we write. */
+			while (len-- > 0)
+				*d++ = *cpy++;
+		} else
+			*d++ = *s++;
+	}
+}
+
+/* Initializes the compressed pool. */
+void
+zswap_init (void) {
+	lock_init (&zswap_lock);
+}
+
+/* Compresses the page at KVA into the pool.  Returns the new entry, with
+ * one reference, or NULL if the page does not compress to at most half a
+ * page or the pool is full. */
+struct zswap_entry *
+zswap_store (const void *kva) {
+	struct zswap_entry *entry = NULL;
+	size_t len, size;
+
+	lock_acquire (&zswap_lock);
+	len = lz_compress (kva, PGSIZE, lz_buffer, sizeof lz_buffer);
+	size = sizeof *entry + len;
+	if (len == 0)
+		reject_cnt++;
+	else if (pool_bytes + size > zswap_pool_pages * PGSIZE)
+		full_cnt++;
+	else if ((entry = malloc (size)) != NULL) {
+		entry->ref_cnt = 1;
+		entry->len = len;
+		memcpy (entry->data, lz_buffer, len);
+		pool_bytes += size;
+		store_cnt++;
+	}
+	lock_release (&zswap_lock);
+	return entry;
+}
+
+/* Decompresses ENTRY into the page at KVA. */
+void
+zswap_load (struct zswap_entry *entry, void *kva) {
+	lz_decompress (entry->data, entry->len, kva, PGSIZE);
+}
+
+/* Adds a reference to ENTRY, for a page that shares it after fork. */
+void
+zswap_get (struct zswap_entry *entry) {
+	lock_acquire (&zswap_lock);
+	entry->ref_cnt++;
+	lock_release (&zswap_lock);
+}
+
+/* Drops a reference to ENTRY, freeing it with the last one. */
+void
+zswap_put (struct zswap_entry *entry) {
+	bool last;
+
+	lock_acquire (&zswap_lock);
+	last = --entry->ref_cnt == 0;
+	if (last)
+		pool_bytes -= sizeof *entry + entry->len;
+	lock_release (&zswap_lock);
+	if (last)
+		free (entry);
+}
+
+/* Prints compressed pool statistics. */
+void
+zswap_print_stats (void) {
+	printf ("Zswap: %lld pages stored, %lld incompressible, %lld pool full, "
+			"%zu bytes in use\n", store_cnt, reject_cnt, full_cnt, pool_bytes);
+}